@@ -1,4 +1,5 @@
 #include <kv/node/main.hpp>
+#include <kv/node/merkle.hpp>
 
 // Node
 #include <whirl/node/runtime/shortcuts.hpp>
@@ -14,6 +15,8 @@
 #include <muesli/serializable.hpp>
 // Support std::string serialization
 #include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+#include <cereal/types/optional.hpp>
 
 // Logging
 #include <timber/log.hpp>
@@ -21,15 +24,23 @@
 // Concurrency
 #include <await/fibers/core/api.hpp>
 #include <await/fibers/sync/future.hpp>
+#include <await/fibers/sync/mutex.hpp>
+#include <await/futures/core/future.hpp>
 #include <await/futures/combine/quorum.hpp>
 #include <await/futures/util/never.hpp>
 
 #include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
 
 using await::fibers::Await;
 using await::futures::Future;
 using wheels::Result;
 
+using kv::MerkleTree;
+
 using namespace whirl;
 
 //////////////////////////////////////////////////////////////////////
@@ -65,28 +76,201 @@ std::ostream& operator<<(std::ostream& out, const WriteTimestamp& ts) {
 
 // Replicas store versioned (stamped) values
 
+// Large values are split into chunks stored separately under
+// (timestamp, index), stamped value is then a header with empty `value`
+// and the number of chunks
+
 struct StampedValue {
   Value value;
   WriteTimestamp timestamp;
+  uint64_t chunks = 0;
 
-  MUESLI_SERIALIZABLE(value, timestamp)
+  bool IsChunked() const {
+    return chunks > 0;
+  }
+
+  MUESLI_SERIALIZABLE(value, timestamp, chunks)
 };
 
 std::ostream& operator<<(std::ostream& out, const StampedValue& stamped_value) {
-  out << "{" << stamped_value.value << ", ts: " << stamped_value.timestamp
-      << "}";
+  if (stamped_value.IsChunked()) {
+    out << "{<" << stamped_value.chunks << " chunks>, ts: "
+        << stamped_value.timestamp << "}";
+  } else {
+    out << "{" << stamped_value.value << ", ts: " << stamped_value.timestamp
+        << "}";
+  }
   return out;
 }
 
+// Storage key of the chunk, timestamp and index go first:
+// user key may contain any characters
+std::string ChunkKey(const Key& key, WriteTimestamp ts, uint64_t index) {
+  return std::to_string(ts.value) + "/" + std::to_string(index) + "/" + key;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// TrueTime interval: the real time is in [earliest, latest],
+// width of the interval is bounded by the TrueTime uncertainty
+// of the time model, so lease expiration is safe under clock drift
+
+struct TrueTimeBounds {
+  uint64_t earliest;
+  uint64_t latest;
+};
+
+TrueTimeBounds TrueTimeNow() {
+  auto now = node::rt::TrueTime()->Now();
+  return {now.earliest.ToJiffies().Count(), now.latest.ToJiffies().Count()};
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Read leases, holder side
+//
+// Key space is split into ranges, a lease on a range is granted
+// by a majority of replicas. Grantors reject writes to the range until
+// the lease is revoked by the holder or expired by their clocks.
+//
+// Lease is valid for the holder until TT.latest < start + duration,
+// where start = TT.earliest before the grant requests were sent.
+// Grantor considers the lease active until
+// TT.earliest > (TT.latest at grant) + duration.
+//
+// Holder caches values read under the lease, revocation drops the cache.
+// Shared by Coordinator (reads) and Replica (revocations) of the same node.
+
+class LeaseTable {
+ public:
+  static const size_t kRanges = 16;
+
+  struct Lease {
+    // Revocation epoch of the range at acquisition
+    uint64_t epoch;
+    uint64_t expires;
+    std::vector<std::string> grantors;
+    std::map<Key, StampedValue> cache;
+  };
+
+  struct Attempt {
+    uint64_t epoch;
+    uint64_t start;
+  };
+
+  LeaseTable() : ranges_(kRanges) {
+  }
+
+  static size_t RangeOf(const Key& key) {
+    return std::hash<Key>{}(key) % kRanges;
+  }
+
+  std::optional<StampedValue> TryReadCached(const Key& key) {
+    auto guard = mutex_.Guard();
+
+    auto& range = ranges_[RangeOf(key)];
+    if (!IsValid(range)) {
+      return std::nullopt;
+    }
+    auto it = range.lease->cache.find(key);
+    if (it == range.lease->cache.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  // Valid lease on the range, if any
+  std::optional<Lease> TryGetLease(size_t index) {
+    auto guard = mutex_.Guard();
+
+    auto& range = ranges_[index];
+    if (!IsValid(range)) {
+      return std::nullopt;
+    }
+    return range.lease;
+  }
+
+  // Do not try to acquire leases on recently revoked (written) ranges
+  std::optional<Attempt> TryBeginAcquire(size_t index) {
+    auto guard = mutex_.Guard();
+
+    auto now = TrueTimeNow();
+    auto& range = ranges_[index];
+    if (now.earliest < range.cooldown_until) {
+      return std::nullopt;
+    }
+    return Attempt{range.epoch, now.earliest};
+  }
+
+  // Fails if the range was revoked while grants were in flight
+  bool CompleteAcquire(size_t index, Attempt attempt, uint64_t duration,
+                       std::vector<std::string> grantors) {
+    auto guard = mutex_.Guard();
+
+    auto& range = ranges_[index];
+    if (range.epoch != attempt.epoch) {
+      return false;
+    }
+    range.lease = Lease{attempt.epoch, attempt.start + duration,
+                        std::move(grantors), {}};
+    return IsValid(range);
+  }
+
+  // Cache value read from the grantors under the lease `epoch`
+  void Cache(const Key& key, uint64_t epoch, StampedValue value) {
+    auto guard = mutex_.Guard();
+
+    auto& range = ranges_[RangeOf(key)];
+    if (range.epoch == epoch && IsValid(range)) {
+      range.lease->cache.insert_or_assign(key, std::move(value));
+    }
+  }
+
+  void Revoke(size_t index, uint64_t cooldown) {
+    auto guard = mutex_.Guard();
+
+    auto& range = ranges_[index];
+    ++range.epoch;
+    range.lease.reset();
+    range.cooldown_until = TrueTimeNow().latest + cooldown;
+  }
+
+ private:
+  struct Range {
+    uint64_t epoch = 0;
+    uint64_t cooldown_until = 0;
+    std::optional<Lease> lease;
+  };
+
+  static bool IsValid(const Range& range) {
+    return range.lease.has_value() &&
+           TrueTimeNow().latest < range.lease->expires;
+  }
+
+ private:
+  await::fibers::Mutex mutex_;
+  std::vector<Range> ranges_;
+};
+
+// GrantLease response
+
+struct LeaseGrant {
+  bool granted;
+  std::string grantor;
+
+  MUESLI_SERIALIZABLE(granted, grantor)
+};
+
 //////////////////////////////////////////////////////////////////////
 
-// Coordinator role, stateless
+// Coordinator role, stateless (except for read leases)
 
 class Coordinator : public commute::rpc::ServiceBase<Coordinator>,
                     public node::cluster::Peer {
  public:
-  Coordinator()
+  explicit Coordinator(std::shared_ptr<LeaseTable> leases)
       : Peer(node::rt::Config()),
+        leases_(std::move(leases)),
         logger_("KVNode.Coordinator", node::rt::LoggerBackend()) {
   }
 
@@ -103,14 +287,26 @@ class Coordinator : public commute::rpc::ServiceBase<Coordinator>,
 
     std::vector<Future<void>> writes;
 
-    // Broadcast LocalWrite
-    for (const auto& peer : ListPeers().WithMe()) {
-      writes.push_back(  //
-          commute::rpc::Call("Replica.LocalWrite")
-              .Args<Key, StampedValue>(key, {value, write_ts})
-              .Via(Channel(peer))
-              .Context(await::context::ThisFiber())
-              .AtLeastOnce());
+    const size_t chunk_size = ChunkSize();
+
+    if (value.size() <= chunk_size) {
+      // Broadcast LocalWrite
+      for (const auto& peer : ListPeers().WithMe()) {
+        writes.push_back(  //
+            commute::rpc::Call("Replica.LocalWrite")
+                .Args<Key, StampedValue>(key, {value, write_ts})
+                .Via(Channel(peer))
+                .Context(await::context::ThisFiber())
+                .AtLeastOnce());
+      }
+    } else {
+      auto chunks = std::make_shared<const std::vector<Value>>(
+          SplitIntoChunks(value, chunk_size));
+
+      // Stream chunks to every replica concurrently
+      for (const auto& peer : ListPeers().WithMe()) {
+        writes.push_back(StreamWrite(peer, key, write_ts, chunks));
+      }
     }
 
     // Await acknowledgements from the majority of storage replicas
@@ -118,6 +314,131 @@ class Coordinator : public commute::rpc::ServiceBase<Coordinator>,
   }
 
   Value Get(Key key) {
+    while (true) {
+      auto stamped_value = ReadStamped(key);
+      if (!stamped_value.IsChunked()) {
+        return stamped_value.value;
+      }
+      if (auto value = StreamRead(key, stamped_value)) {
+        return std::move(*value);
+      }
+      // Chunks were collected after a newer write, retry
+    }
+  }
+
+ private:
+  StampedValue ReadStamped(const Key& key) {
+    if (auto cached = leases_->TryReadCached(key)) {
+      return *cached;
+    }
+
+    if (auto lease = TryAcquireLease(LeaseTable::RangeOf(key))) {
+      if (auto stamped_value = ReadFromGrantors(key, *lease)) {
+        return *stamped_value;
+      }
+    }
+
+    return QuorumRead(key);
+  }
+
+  // Chunked values
+
+  static size_t ChunkSize() {
+    return node::rt::Config()->GetInt<size_t>("kv.chunk_size");
+  }
+
+  static std::vector<Value> SplitIntoChunks(const Value& value,
+                                            size_t chunk_size) {
+    std::vector<Value> chunks;
+    for (size_t offset = 0; offset < value.size(); offset += chunk_size) {
+      chunks.push_back(value.substr(offset, chunk_size));
+    }
+    return chunks;
+  }
+
+  // Stream chunks one by one, then commit header with LocalWrite
+  Future<void> StreamWrite(std::string peer, Key key, WriteTimestamp ts,
+                           std::shared_ptr<const std::vector<Value>> chunks) {
+    auto [future, promise] = await::futures::MakeContract<void>();
+
+    await::fibers::Go([this, peer = std::move(peer), key = std::move(key), ts,
+                       chunks = std::move(chunks),
+                       promise = std::move(promise)]() mutable {
+      for (size_t index = 0; index < chunks->size(); ++index) {
+        auto ack = Await(commute::rpc::Call("Replica.WriteChunk")
+                             .Args<Key, WriteTimestamp, uint64_t, Value>(
+                                 key, ts, index, (*chunks)[index])
+                             .Via(Channel(peer))
+                             .Context(await::context::ThisFiber())
+                             .AtLeastOnce()
+                             .Start()
+                             .As<void>());
+        if (!ack.IsOk()) {
+          std::move(promise).SetError(ack.GetError());
+          return;
+        }
+      }
+
+      auto commit = Await(commute::rpc::Call("Replica.LocalWrite")
+                              .Args<Key, StampedValue>(
+                                  key, {"", ts, chunks->size()})
+                              .Via(Channel(peer))
+                              .Context(await::context::ThisFiber())
+                              .AtLeastOnce()
+                              .Start()
+                              .As<void>());
+      if (!commit.IsOk()) {
+        std::move(promise).SetError(commit.GetError());
+        return;
+      }
+
+      std::move(promise).SetValue();
+    });
+
+    return std::move(future);
+  }
+
+  // Stream chunks from a single replica that holds the version,
+  // starting with the local one
+  std::optional<Value> StreamRead(const Key& key, const StampedValue& header) {
+    std::vector<std::string> peers{node::rt::HostName()};
+    for (const auto& peer : ListPeers().WithoutMe()) {
+      peers.push_back(peer);
+    }
+
+    for (const auto& peer : peers) {
+      if (auto value = TryStreamFrom(peer, key, header)) {
+        return value;
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::optional<Value> TryStreamFrom(const std::string& peer, const Key& key,
+                                     const StampedValue& header) {
+    Value value;
+
+    for (uint64_t index = 0; index < header.chunks; ++index) {
+      auto chunk = Await(commute::rpc::Call("Replica.ReadChunk")
+                             .Args<Key, WriteTimestamp, uint64_t>(
+                                 key, header.timestamp, index)
+                             .Via(Channel(peer))
+                             .Context(await::context::ThisFiber())
+                             .AtMostOnce()
+                             .Start()
+                             .As<std::optional<Value>>());
+
+      if (!chunk.IsOk() || !chunk->has_value()) {
+        return std::nullopt;
+      }
+
+      value.append(**chunk);
+    }
+
+    return value;
+  }
+
+  StampedValue QuorumRead(Key key) {
     std::vector<Future<StampedValue>> reads;
 
     // Broadcast LocalRead
@@ -134,11 +455,86 @@ class Coordinator : public commute::rpc::ServiceBase<Coordinator>,
         Await(Quorum(std::move(reads), /*threshold=*/Majority()))
             .ValueOrThrow();
 
-    auto most_recent = FindMostRecent(stamped_values);
-    return most_recent.value;
+    return FindMostRecent(stamped_values);
+  }
+
+  // Read leases
+
+  std::optional<LeaseTable::Lease> TryAcquireLease(size_t range) {
+    if (auto lease = leases_->TryGetLease(range)) {
+      return lease;
+    }
+
+    auto attempt = leases_->TryBeginAcquire(range);
+    if (!attempt.has_value()) {
+      return std::nullopt;
+    }
+
+    std::vector<Future<LeaseGrant>> grants;
+
+    for (const auto& peer : ListPeers().WithMe()) {
+      grants.push_back(  //
+          commute::rpc::Call("Replica.GrantLease")
+              .Args<uint64_t, std::string>(range, node::rt::HostName())
+              .Via(Channel(peer))
+              .Context(await::context::ThisFiber())
+              .AtMostOnce());
+    }
+
+    auto replies = Await(Quorum(std::move(grants), /*threshold=*/Majority()));
+    if (!replies.IsOk()) {
+      return std::nullopt;
+    }
+
+    std::vector<std::string> grantors;
+    for (const auto& reply : *replies) {
+      if (!reply.granted) {
+        // Leftover grants block writers until revoked or expired
+        return std::nullopt;
+      }
+      grantors.push_back(reply.grantor);
+    }
+
+    if (!leases_->CompleteAcquire(range, *attempt, LeaseDuration(),
+                                  std::move(grantors))) {
+      return std::nullopt;
+    }
+
+    LOG_INFO("Acquired read lease on range {}", range);
+
+    return leases_->TryGetLease(range);
+  }
+
+  // Every write applied by a grantor before the grant is visible here,
+  // every later write revokes the lease
+  std::optional<StampedValue> ReadFromGrantors(const Key& key,
+                                               const LeaseTable::Lease& lease) {
+    std::vector<Future<StampedValue>> reads;
+
+    for (const auto& grantor : lease.grantors) {
+      reads.push_back(  //
+          commute::rpc::Call("Replica.LocalRead")
+              .Args(key)
+              .Via(Channel(grantor))
+              .Context(await::context::ThisFiber())
+              .AtMostOnce());
+    }
+
+    auto stamped_values =
+        Await(Quorum(std::move(reads), /*threshold=*/lease.grantors.size()));
+    if (!stamped_values.IsOk()) {
+      return std::nullopt;
+    }
+
+    auto most_recent = FindMostRecent(*stamped_values);
+    leases_->Cache(key, lease.epoch, most_recent);
+    return most_recent;
+  }
+
+  static uint64_t LeaseDuration() {
+    return node::rt::Config()->GetInt<uint64_t>("kv.lease.duration");
   }
 
- private:
   WriteTimestamp ChooseWriteTimestamp() const {
     return {node::rt::WallTimeNow().ToJiffies().Count()};
   }
@@ -158,49 +554,484 @@ class Coordinator : public commute::rpc::ServiceBase<Coordinator>,
   }
 
  private:
+  std::shared_ptr<LeaseTable> leases_;
   timber::Logger logger_;
 };
 
 //////////////////////////////////////////////////////////////////////
 
+// Anti-entropy digest of a single key version
+
+struct KeyStamp {
+  Key key;
+  WriteTimestamp timestamp;
+
+  MUESLI_SERIALIZABLE(key, timestamp)
+};
+
+//////////////////////////////////////////////////////////////////////
+
 // Storage replica role
 
-class Replica : public commute::rpc::ServiceBase<Replica> {
+class Replica : public commute::rpc::ServiceBase<Replica>,
+                public node::cluster::Peer {
+  // Number of key buckets (Merkle tree leaves)
+  static const size_t kBuckets = 64;
+
  public:
-  Replica()
-      : kv_store_(node::rt::Database(), "data"),
+  explicit Replica(std::shared_ptr<LeaseTable> leases)
+      : Peer(node::rt::Config()),
+        kv_store_(node::rt::Database(), "data"),
+        chunks_store_(node::rt::Database(), "chunks"),
+        leases_(std::move(leases)),
+        bucket_keys_store_(node::rt::Database(), "bucket_keys"),
+        bucket_sizes_store_(node::rt::Database(), "bucket_sizes"),
+        bucket_sizes_(kBuckets, 0),
+        tree_(kBuckets),
+        buckets_(kBuckets),
         logger_("KVNode.Replica", node::rt::LoggerBackend()) {
   }
 
   void RegisterMethods() override {
     COMMUTE_RPC_REGISTER_METHOD(LocalWrite);
     COMMUTE_RPC_REGISTER_METHOD(LocalRead);
+
+    // Chunked values
+    COMMUTE_RPC_REGISTER_METHOD(WriteChunk);
+    COMMUTE_RPC_REGISTER_METHOD(ReadChunk);
+
+    // Anti-entropy
+    COMMUTE_RPC_REGISTER_METHOD(MerkleHashes);
+    COMMUTE_RPC_REGISTER_METHOD(BucketStamps);
+
+    // Read leases
+    COMMUTE_RPC_REGISTER_METHOD(GrantLease);
+    COMMUTE_RPC_REGISTER_METHOD(RevokeLease);
   };
 
+  // Rebuild Merkle tree from local storage, launch anti-entropy fiber
+  // Call before serving requests
+  void Start() {
+    RecoverTree();
+
+    // Grants issued before restart are lost, wait them out before writes
+    writes_fenced_until_ = TrueTimeNow().latest + LeaseDuration();
+
+    await::fibers::Go([this]() {
+      RunAntiEntropy();
+    });
+  }
+
   // RPC handlers
 
   void LocalWrite(Key key, StampedValue target_value) {
+    size_t range = LeaseTable::RangeOf(key);
+
+    // No grants on the range until the write is applied
+    BeginWrite(range);
+    ReleaseLease(range);
+
+    {
+      auto guard = mutex_.Guard();
+      ApplyWrite(key, target_value);
+    }
+
+    EndWrite(range);
+  }
+
+  StampedValue LocalRead(Key key) {
+    return kv_store_.GetOr(key, {"", WriteTimestamp::Min()});
+  }
+
+  // Chunked values
+
+  // Stage chunk, version becomes visible on LocalWrite of its header
+  void WriteChunk(Key key, WriteTimestamp ts, uint64_t index, Value chunk) {
+    auto local_value = kv_store_.TryGet(key);
+    if (local_value.has_value() && ts < local_value->timestamp) {
+      return;  // Obsolete
+    }
+    chunks_store_.Put(ChunkKey(key, ts, index), chunk);
+  }
+
+  std::optional<Value> ReadChunk(Key key, WriteTimestamp ts, uint64_t index) {
+    return chunks_store_.TryGet(ChunkKey(key, ts, index));
+  }
+
+  // Read leases
+
+  LeaseGrant GrantLease(uint64_t range, std::string holder) {
+    auto guard = leases_mutex_.Guard();
+
+    auto now = TrueTimeNow();
+
+    if (now.earliest <= writes_fenced_until_ || pending_writes_[range] > 0) {
+      return {false, node::rt::HostName()};
+    }
+
+    if (auto it = grants_.find(range); it != grants_.end()) {
+      const auto& grant = it->second;
+      if (grant.holder != holder && now.earliest <= grant.expires) {
+        return {false, node::rt::HostName()};
+      }
+    }
+
+    // Renewal by the same holder extends the grant
+    grants_.insert_or_assign(range, Grant{holder, now.latest + LeaseDuration()});
+
+    return {true, node::rt::HostName()};
+  }
+
+  // Called on the holder
+  void RevokeLease(uint64_t range) {
+    LOG_INFO("Read lease on range {} revoked", range);
+    leases_->Revoke(range, /*cooldown=*/LeaseDuration());
+  }
+
+  // Anti-entropy
+
+  std::vector<MerkleTree::Hash> MerkleHashes(
+      std::vector<MerkleTree::NodeId> nodes) {
+    std::vector<MerkleTree::Hash> hashes;
+    hashes.reserve(nodes.size());
+    for (auto node : nodes) {
+      hashes.push_back(tree_.IsValid(node) ? tree_.Get(node) : 0);
+    }
+    return hashes;
+  }
+
+  std::vector<KeyStamp> BucketStamps(uint64_t bucket) {
+    std::vector<KeyStamp> stamps;
+    if (bucket < buckets_.size()) {
+      for (const auto& [key, ts] : buckets_[bucket]) {
+        stamps.push_back({key, ts});
+      }
+    }
+    return stamps;
+  }
+
+ private:
+  // With mutex
+  void ApplyWrite(Key key, StampedValue target_value) {
     std::optional<StampedValue> local_value = kv_store_.TryGet(key);
 
     if (!local_value.has_value()) {
       // First write for this key
-      Update(key, target_value);
+      Update(key, target_value, std::nullopt);
     } else {
       // Write timestamp > timestamp of locally stored value
       if (local_value->timestamp < target_value.timestamp) {
-        Update(key, target_value);
+        Update(key, target_value, local_value->timestamp);
+        DropChunks(key, *local_value);
+      } else if (target_value.timestamp < local_value->timestamp) {
+        DropChunks(key, target_value);
       }
     }
   }
 
-  StampedValue LocalRead(Key key) {
-    return kv_store_.GetOr(key, {"", WriteTimestamp::Min()});
+  // Collect chunks of the superseded version
+  void DropChunks(const Key& key, const StampedValue& stamped_value) {
+    for (uint64_t index = 0; index < stamped_value.chunks; ++index) {
+      chunks_store_.Delete(ChunkKey(key, stamped_value.timestamp, index));
+    }
   }
 
- private:
-  void Update(Key key, StampedValue target_value) {
+  // With mutex
+  void Update(Key key, StampedValue target_value,
+              std::optional<WriteTimestamp> prev_ts) {
     LOG_INFO("Write '{}' -> {}", key, target_value);
+
+    size_t bucket = BucketOf(key);
+
+    // Indexed before the value is stored: every stored key is in the
+    // index after a crash
+    if (!prev_ts.has_value()) {
+      IndexKey(bucket, key);
+    }
+
     kv_store_.Put(key, target_value);
+
+    if (prev_ts.has_value()) {
+      tree_.Toggle(bucket, Digest(key, *prev_ts));
+    }
+    tree_.Toggle(bucket, Digest(key, target_value.timestamp));
+
+    buckets_[bucket].insert_or_assign(key, target_value.timestamp);
+  }
+
+  // Persist key in bucket index, used to rebuild the tree after restart
+  // One record per key: (bucket, position) -> key, then the bucket size.
+  // A record written before a crash but not counted is overwritten
+  void IndexKey(size_t bucket, const Key& key) {
+    auto position = bucket_sizes_[bucket]++;
+    bucket_keys_store_.Put(BucketKeyId(bucket, position), key);
+    bucket_sizes_store_.Put(std::to_string(bucket), bucket_sizes_[bucket]);
+  }
+
+  static std::string BucketKeyId(size_t bucket, uint64_t position) {
+    return std::to_string(bucket) + "/" + std::to_string(position);
+  }
+
+  void RecoverTree() {
+    auto guard = mutex_.Guard();
+
+    for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+      bucket_sizes_[bucket] =
+          bucket_sizes_store_.GetOr(std::to_string(bucket), 0);
+
+      for (uint64_t position = 0; position < bucket_sizes_[bucket];
+           ++position) {
+        auto key = bucket_keys_store_.TryGet(BucketKeyId(bucket, position));
+        if (!key.has_value() || buckets_[bucket].count(*key) > 0) {
+          continue;  // Indexed again after a crash before the value write
+        }
+        auto stamped_value = kv_store_.TryGet(*key);
+        if (!stamped_value.has_value()) {
+          continue;  // Crashed between index and value writes
+        }
+        tree_.Toggle(bucket, Digest(*key, stamped_value->timestamp));
+        buckets_[bucket].insert_or_assign(*key, stamped_value->timestamp);
+      }
+    }
+  }
+
+  // Read leases, grantor side
+
+  void BeginWrite(size_t range) {
+    auto guard = leases_mutex_.Guard();
+    ++pending_writes_[range];
+  }
+
+  void EndWrite(size_t range) {
+    auto guard = leases_mutex_.Guard();
+    --pending_writes_[range];
+  }
+
+  // Revoke active grant on the range or wait it out
+  void ReleaseLease(size_t range) {
+    while (true) {
+      std::optional<Grant> grant;
+
+      {
+        auto guard = leases_mutex_.Guard();
+
+        auto now = TrueTimeNow();
+
+        if (now.earliest <= writes_fenced_until_) {
+          grant = Grant{"", writes_fenced_until_};
+        } else if (auto it = grants_.find(range); it != grants_.end()) {
+          if (now.earliest > it->second.expires) {
+            grants_.erase(it);
+            return;
+          }
+          grant = it->second;
+        } else {
+          return;
+        }
+      }
+
+      if (!grant->holder.empty() && TryRevoke(range, grant->holder)) {
+        auto guard = leases_mutex_.Guard();
+        // Pending write blocks new grants, so it is still the same grant
+        grants_.erase(range);
+        return;
+      }
+
+      // Holder is unreachable: wait until the lease expires by our clock
+      // Revoke RPC takes time, the grant may have expired meanwhile
+      auto now = TrueTimeNow();
+      if (now.earliest <= grant->expires) {
+        node::rt::SleepFor(grant->expires - now.earliest + 1);
+      }
+    }
+  }
+
+  bool TryRevoke(size_t range, const std::string& holder) {
+    if (holder == node::rt::HostName()) {
+      RevokeLease(range);
+      return true;
+    }
+
+    auto revoked = Await(commute::rpc::Call("Replica.RevokeLease")
+                             .Args<uint64_t>(range)
+                             .Via(Channel(holder))
+                             .Context(await::context::ThisFiber())
+                             .AtMostOnce()
+                             .Start()
+                             .As<void>());
+
+    return revoked.IsOk();
+  }
+
+  static uint64_t LeaseDuration() {
+    return node::rt::Config()->GetInt<uint64_t>("kv.lease.duration");
+  }
+
+  // Anti-entropy
+
+  void RunAntiEntropy() {
+    await::fibers::self::SetName("anti-entropy");
+
+    const Jiffies period = node::rt::Config()->GetInt<uint64_t>(
+        "kv.anti_entropy.period");
+
+    while (true) {
+      // Background activity: keep it rare and randomized
+      node::rt::SleepFor(period + node::rt::RandomNumber(period.Count()));
+
+      auto peers = ListPeers().WithoutMe();
+      if (peers.empty()) {
+        continue;
+      }
+
+      SyncWith(peers[node::rt::RandomIndex(peers.size())]);
+    }
+  }
+
+  // Pull values that are fresher on the peer
+  void SyncWith(const std::string& peer) {
+    auto buckets = FindDivergentBuckets(peer);
+    if (buckets.empty()) {
+      return;
+    }
+
+    LOG_INFO("{} divergent buckets with {}", buckets.size(), peer);
+
+    // Rate limit: bound the number of values pulled per round
+    size_t budget = node::rt::Config()->GetInt<size_t>("kv.anti_entropy.batch");
+
+    for (auto bucket : buckets) {
+      if (budget == 0) {
+        break;
+      }
+
+      auto remote_stamps = Await(commute::rpc::Call("Replica.BucketStamps")
+                                     .Args<uint64_t>(bucket)
+                                     .Via(Channel(peer))
+                                     .Context(await::context::ThisFiber())
+                                     .AtMostOnce()
+                                     .Start()
+                                     .As<std::vector<KeyStamp>>());
+
+      if (!remote_stamps.IsOk()) {
+        return;
+      }
+
+      for (const auto& stamp : *remote_stamps) {
+        if (budget == 0) {
+          break;
+        }
+        if (!IsStale(bucket, stamp)) {
+          continue;
+        }
+
+        auto value = Await(commute::rpc::Call("Replica.LocalRead")
+                               .Args(stamp.key)
+                               .Via(Channel(peer))
+                               .Context(await::context::ThisFiber())
+                               .AtMostOnce()
+                               .Start()
+                               .As<StampedValue>());
+
+        if (!value.IsOk()) {
+          return;
+        }
+
+        if (value->IsChunked() && !PullChunks(peer, stamp.key, *value)) {
+          continue;
+        }
+
+        LOG_INFO("Repair '{}' from {}: {}", stamp.key, peer, *value);
+        LocalWrite(stamp.key, *value);
+
+        --budget;
+      }
+    }
+  }
+
+  // Stage chunks of the version before committing its header
+  bool PullChunks(const std::string& peer, const Key& key,
+                  const StampedValue& header) {
+    for (uint64_t index = 0; index < header.chunks; ++index) {
+      auto chunk = Await(commute::rpc::Call("Replica.ReadChunk")
+                             .Args<Key, WriteTimestamp, uint64_t>(
+                                 key, header.timestamp, index)
+                             .Via(Channel(peer))
+                             .Context(await::context::ThisFiber())
+                             .AtMostOnce()
+                             .Start()
+                             .As<std::optional<Value>>());
+
+      if (!chunk.IsOk() || !chunk->has_value()) {
+        return false;
+      }
+
+      WriteChunk(key, header.timestamp, index, **chunk);
+    }
+    return true;
+  }
+
+  // Descend the tree level by level, comparing only divergent subtrees
+  std::vector<uint64_t> FindDivergentBuckets(const std::string& peer) {
+    std::vector<uint64_t> buckets;
+
+    std::vector<MerkleTree::NodeId> frontier{MerkleTree::Root()};
+
+    while (!frontier.empty()) {
+      auto remote_hashes = RemoteHashes(peer, frontier);
+      if (!remote_hashes.has_value() ||
+          remote_hashes->size() != frontier.size()) {
+        return {};
+      }
+
+      std::vector<MerkleTree::NodeId> next;
+
+      for (size_t i = 0; i < frontier.size(); ++i) {
+        auto node = frontier[i];
+        if (tree_.Get(node) == (*remote_hashes)[i]) {
+          continue;  // Subtrees are in sync
+        }
+        if (tree_.IsLeaf(node)) {
+          buckets.push_back(tree_.BucketOf(node));
+        } else {
+          next.push_back(tree_.LeftChild(node));
+          next.push_back(tree_.RightChild(node));
+        }
+      }
+
+      frontier = std::move(next);
+    }
+
+    return buckets;
+  }
+
+  std::optional<std::vector<MerkleTree::Hash>> RemoteHashes(
+      const std::string& peer, std::vector<MerkleTree::NodeId> nodes) {
+    auto hashes = Await(commute::rpc::Call("Replica.MerkleHashes")
+                            .Args(nodes)
+                            .Via(Channel(peer))
+                            .Context(await::context::ThisFiber())
+                            .AtMostOnce()
+                            .Start()
+                            .As<std::vector<MerkleTree::Hash>>());
+    if (!hashes.IsOk()) {
+      return std::nullopt;
+    }
+    return *hashes;
+  }
+
+  bool IsStale(size_t bucket, const KeyStamp& remote) const {
+    auto it = buckets_[bucket].find(remote.key);
+    return it == buckets_[bucket].end() || it->second < remote.timestamp;
+  }
+
+  static size_t BucketOf(const Key& key) {
+    return std::hash<Key>{}(key) % kBuckets;
+  }
+
+  static MerkleTree::Hash Digest(const Key& key, WriteTimestamp ts) {
+    // Never zero for a live key version
+    return (std::hash<Key>{}(key) ^ (ts.value * 0x9e3779b97f4a7c15ULL)) | 1;
   }
 
  private:
@@ -208,6 +1039,40 @@ class Replica : public commute::rpc::ServiceBase<Replica> {
   // strings -> StampedValues
   node::store::KVStore<StampedValue> kv_store_;
 
+  // Chunks of large values
+  // ChunkKey -> bytes
+  node::store::KVStore<Value> chunks_store_;
+
+  // Read leases
+  struct Grant {
+    std::string holder;
+    uint64_t expires;
+  };
+
+  std::shared_ptr<LeaseTable> leases_;
+  await::fibers::Mutex leases_mutex_;
+  // Range -> active grant
+  std::map<uint64_t, Grant> grants_;
+  // Range -> number of in-flight writes
+  std::map<uint64_t, size_t> pending_writes_;
+  // Grants issued before restart may still be active
+  uint64_t writes_fenced_until_ = 0;
+
+  // Bucket index for anti-entropy recovery:
+  // (bucket, position) -> key, bucket -> number of positions
+  node::store::KVStore<Key> bucket_keys_store_;
+  node::store::KVStore<uint64_t> bucket_sizes_store_;
+  // Cached bucket_sizes_store_, guarded by mutex_
+  std::vector<uint64_t> bucket_sizes_;
+
+  // Serializes local writes and anti-entropy state updates
+  await::fibers::Mutex mutex_;
+
+  // In-memory anti-entropy state
+  MerkleTree tree_;
+  // Bucket -> (key -> timestamp of the locally stored version)
+  std::vector<std::map<Key, WriteTimestamp>> buckets_;
+
   timber::Logger logger_;
 };
 
@@ -228,8 +1093,16 @@ void KVNodeMain() {
   auto rpc_port = node::rt::Config()->GetInt<uint16_t>("rpc.port");
   auto rpc_server = node::rpc::MakeServer(rpc_port);
 
-  rpc_server->RegisterService("KV", std::make_shared<Coordinator>());
-  rpc_server->RegisterService("Replica", std::make_shared<Replica>());
+  // Read leases held by this node
+  auto leases = std::make_shared<LeaseTable>();
+
+  auto replica = std::make_shared<Replica>(leases);
+
+  rpc_server->RegisterService("KV", std::make_shared<Coordinator>(leases));
+  rpc_server->RegisterService("Replica", replica);
+
+  // Recover anti-entropy state before serving writes
+  replica->Start();
 
   rpc_server->Start();
 
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <wheels/support/panic.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace kv {
+
+// Fixed-shape Merkle tree over key buckets
+//
+// Leaves are buckets of the key space, leaf hash = XOR of digests
+// of all (key, version) pairs in the bucket, so a single write updates
+// its leaf in O(1) and the path to the root in O(log(leaves)).
+//
+// Nodes are numbered as in a binary heap: root = 1,
+// children of node i = 2i, 2i + 1, leaves = [leaves, 2 * leaves)
+
+class MerkleTree {
+ public:
+  using Hash = uint64_t;
+  using NodeId = uint64_t;
+
+  // leaves should be a power of two
+  explicit MerkleTree(size_t leaves) : leaves_(leaves), nodes_(2 * leaves, 0) {
+    if (leaves == 0 || (leaves & (leaves - 1)) != 0) {
+      WHEELS_PANIC("Number of Merkle tree leaves should be a power of two");
+    }
+  }
+
+  static NodeId Root() {
+    return 1;
+  }
+
+  size_t LeafCount() const {
+    return leaves_;
+  }
+
+  bool IsLeaf(NodeId node) const {
+    return node >= leaves_;
+  }
+
+  size_t BucketOf(NodeId leaf) const {
+    return leaf - leaves_;
+  }
+
+  NodeId LeftChild(NodeId node) const {
+    return 2 * node;
+  }
+
+  NodeId RightChild(NodeId node) const {
+    return 2 * node + 1;
+  }
+
+  bool IsValid(NodeId node) const {
+    return node >= 1 && node < nodes_.size();
+  }
+
+  Hash Get(NodeId node) const {
+    return nodes_.at(node);
+  }
+
+  // Add or remove (XOR is an involution) digest to / from bucket
+  void Toggle(size_t bucket, Hash digest) {
+    NodeId node = leaves_ + bucket;
+    nodes_.at(node) ^= digest;
+
+    // Recompute path to the root
+    while (node > Root()) {
+      node /= 2;
+      nodes_[node] = Combine(nodes_[LeftChild(node)], nodes_[RightChild(node)]);
+    }
+  }
+
+ private:
+  static Hash Combine(Hash lhs, Hash rhs) {
+    // Empty subtrees hash to zero, so equal subtrees
+    // on different replicas compare equal regardless of history
+    if (lhs == 0 && rhs == 0) {
+      return 0;
+    }
+    return Mix(lhs * 31 + Mix(rhs));
+  }
+
+  // splitmix64 finalizer
+  static Hash Mix(Hash x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+ private:
+  const size_t leaves_;
+  std::vector<Hash> nodes_;
+};
+
+}  // namespace kv
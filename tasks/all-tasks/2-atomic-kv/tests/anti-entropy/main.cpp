@@ -0,0 +1,329 @@
+#include <kv/node/main.hpp>
+#include <kv/node/merkle.hpp>
+#include <kv/client/client.hpp>
+
+// Node
+#include <whirl/node/runtime/shortcuts.hpp>
+#include <whirl/node/cluster/peer.hpp>
+
+// RPC
+#include <commute/rpc/call.hpp>
+#include <commute/rpc/id.hpp>
+
+// Serialization
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+// Logging
+#include <timber/log.hpp>
+
+// Concurrency
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/sync/future.hpp>
+
+// Simulation
+#include <matrix/facade/world.hpp>
+#include <matrix/world/global/vars.hpp>
+#include <matrix/world/global/time.hpp>
+#include <matrix/client/rpc.hpp>
+#include <matrix/test/main.hpp>
+#include <matrix/test/event_log.hpp>
+#include <matrix/test/runner.hpp>
+
+#include <matrix/time_model/catalog/crazy.hpp>
+
+#include <matrix/fault/access.hpp>
+#include <matrix/fault/net/split.hpp>
+#include <matrix/fault/util.hpp>
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace whirl;
+
+//////////////////////////////////////////////////////////////////////
+
+// Replicas converge after a partition heals
+//
+// Clients write while the network is split, so replicas on the minority
+// side miss writes. Then every node is rebooted, which drops in-flight
+// LocalWrite retries of the coordinators, and the network heals:
+// from this point only anti-entropy can repair the missed writes.
+//
+// Replicas are converged when roots of their Merkle trees are equal,
+// i.e. they store the same (key, timestamp) pairs
+//
+// Simulation parameters are derived from the seed, so any --sims
+// covers all configs evenly
+
+struct AntiEntropyConfig {
+  // kv.anti_entropy.period
+  size_t period;
+  // kv.anti_entropy.batch
+  size_t batch;
+};
+
+static const std::vector<AntiEntropyConfig> kAntiEntropyConfigs{
+    {100, 4},
+    {100, 64},
+    {500, 64},
+};
+
+static const size_t kReplicas = 5;
+static const size_t kClients = 3;
+static const size_t kKeys = 32;
+
+static const matrix::TimePoint kPartitionStart = 500;
+// Clients stop writing, nodes are rebooted, network heals
+static const matrix::TimePoint kHeal = 3000;
+static const Jiffies kTimeLimit = 60000_jfs;
+
+// Root hashes are sampled with this period
+static const Jiffies kProbePeriod = 50_jfs;
+
+//////////////////////////////////////////////////////////////////////
+
+struct AntiEntropyStats {
+  size_t runs = 0;
+  uint64_t time = 0;
+
+  double MeanTime() const {
+    return runs > 0 ? 1.0 * time / runs : 0;
+  }
+};
+
+static std::vector<AntiEntropyStats> anti_entropy_stats(
+    kAntiEntropyConfigs.size());
+
+// Current simulation
+
+struct RootSample {
+  kv::MerkleTree::Hash hash;
+  matrix::TimePoint time;
+};
+
+// Host -> last sampled Merkle root
+static std::map<std::string, RootSample> roots;
+// Client requests in progress
+static size_t in_flight = 0;
+// Completion of the last client request
+static matrix::TimePoint last_request = 0;
+
+//////////////////////////////////////////////////////////////////////
+
+// Samples Merkle root of the local replica
+
+class RootProbe : public node::cluster::Peer {
+ public:
+  RootProbe() : Peer(node::rt::Config()) {
+  }
+
+  void Run() {
+    while (true) {
+      node::rt::SleepFor(kProbePeriod);
+
+      if (matrix::GlobalNow() < kHeal) {
+        continue;
+      }
+
+      auto hashes = await::fibers::Await(
+          commute::rpc::Call("Replica.MerkleHashes")
+              .Args(std::vector<kv::MerkleTree::NodeId>{
+                  kv::MerkleTree::Root()})
+              .Via(Channel(node::rt::HostName()))
+              .Context(await::context::ThisFiber())
+              .AtMostOnce()
+              .Start()
+              .As<std::vector<kv::MerkleTree::Hash>>());
+
+      if (hashes.IsOk() && hashes->size() == 1) {
+        roots.insert_or_assign(node::rt::HostName(),
+                               RootSample{(*hashes)[0], matrix::GlobalNow()});
+      }
+    }
+  }
+};
+
+void KVReplicaMain() {
+  await::fibers::Go([]() {
+    RootProbe().Run();
+  });
+
+  KVNodeMain();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Client() {
+  await::fibers::self::SetName("main");
+
+  node::rt::SleepFor(123_jfs);
+
+  timber::Logger logger_{"Client", node::rt::LoggerBackend()};
+
+  kv::BlockingClient kv_store{matrix::client::MakeRpcChannel(
+      /*pool_name=*/"kv", /*port=*/42)};
+
+  while (matrix::GlobalNow() < kHeal) {
+    auto key = "k" + std::to_string(node::rt::RandomNumber(kKeys));
+    auto value = std::to_string(node::rt::RandomNumber(10, 100));
+
+    ++in_flight;
+    LOG_INFO("Execute Set({}, {})", key, value);
+    kv_store.Set(key, value);
+    --in_flight;
+    last_request = matrix::GlobalNow();
+
+    node::rt::SleepFor(node::rt::RandomNumber(1, 50));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Partition() {
+  timber::Logger logger_{"Partition", node::rt::LoggerBackend()};
+
+  auto pool = node::rt::Discovery()->ListPool("kv");
+
+  node::rt::SleepFor(kPartitionStart);
+
+  // Majority keeps serving writes
+  size_t minority = (pool.size() - 1) / 2;
+  LOG_INFO("Random split: {}/{}", minority, pool.size() - minority);
+  matrix::fault::RandomSplit(pool, minority);
+
+  node::rt::SleepFor(kHeal - kPartitionStart);
+
+  // Storage is durable, coordinator retries are gone
+  for (const auto& host : pool) {
+    LOG_INFO("Reboot {}", host);
+    matrix::fault::Server(host).FastReboot();
+  }
+
+  LOG_INFO("Heal network");
+  matrix::fault::Network().Heal();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Every replica sampled since clients are done, all samples equal
+bool Converged() {
+  if (in_flight > 0 || roots.size() < kReplicas) {
+    return false;
+  }
+
+  for (const auto& [_, sample] : roots) {
+    if (sample.time < kHeal || sample.time <= last_request ||
+        sample.hash != roots.begin()->second.hash) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Seed -> simulation digest
+// Deterministic
+size_t RunSimulation(size_t seed) {
+  auto& runner = matrix::TestRunner::Access();
+
+  size_t anti_entropy_config = seed % kAntiEntropyConfigs.size();
+  const auto& config = kAntiEntropyConfigs[anti_entropy_config];
+
+  runner.Verbose() << "Simulation seed: " << seed
+                   << ", period: " << config.period
+                   << ", batch: " << config.batch << std::endl;
+
+  roots.clear();
+  in_flight = 0;
+  last_request = 0;
+
+  // Reset RPC ids
+  commute::rpc::ResetIds();
+
+  matrix::facade::World world{seed};
+
+  // Time model
+  world.SetTimeModel(matrix::MakeCrazyTimeModel());
+
+  // Cluster
+  world.MakePool("kv", KVReplicaMain).Size(kReplicas);
+
+  // Clients
+  world.AddClients(Client, /*count=*/kClients);
+
+  world.AddAdversary(Partition);
+
+  // Log file
+
+  if (auto path = runner.LogFile()) {
+    world.WriteLogTo(*path);
+  }
+
+  world.SetGlobal<int64_t>("config.kv.anti_entropy.period",
+                           (int64_t)config.period);
+  world.SetGlobal<int64_t>("config.kv.anti_entropy.batch",
+                           (int64_t)config.batch);
+  world.SetGlobal<int64_t>("config.kv.lease.duration", 300);
+  // Two-digit values are chunked, repairs pull chunks
+  world.SetGlobal<int64_t>("config.kv.chunk_size", 1);
+
+  // Run simulation
+
+  world.Start();
+  while (!Converged() && world.TimeElapsed() < kTimeLimit) {
+    if (!world.Step()) {
+      break;  // Deadlock
+    }
+  }
+
+  const bool converged = Converged();
+
+  if (converged) {
+    auto& stats = anti_entropy_stats[anti_entropy_config];
+    ++stats.runs;
+    stats.time += world.TimeElapsed().Count() - kHeal;
+  }
+
+  size_t digest = world.Stop();
+
+  runner.Verbose() << "Seed " << seed << " -> "
+                   << "converged: " << converged
+                   << ", time: " << world.TimeElapsed() << std::endl;
+
+  if (!converged) {
+    runner.Report() << "Log:" << std::endl;
+    matrix::WriteTextLog(world.EventLog(), runner.Report());
+    runner.Report() << std::endl;
+
+    runner.Report() << "Simulation for seed = " << seed
+                    << ": replicas did not converge" << std::endl;
+    runner.Fail();
+  }
+
+  return digest;
+}
+
+void PrintAntiEntropyReport(std::ostream& out) {
+  out << "Time to converge after " << kHeal - kPartitionStart
+      << " jiffies partition, " << kReplicas << " replicas:" << std::endl;
+  for (size_t i = 0; i < kAntiEntropyConfigs.size(); ++i) {
+    const auto& config = kAntiEntropyConfigs[i];
+    const auto& stats = anti_entropy_stats[i];
+    out << "  period = " << config.period << ", batch = " << config.batch
+        << ": " << stats.MeanTime() << " jiffies (" << stats.runs
+        << " runs)" << std::endl;
+  }
+}
+
+// Usage:
+// 1) --det --sims 300 - check determinism and run 300 simulations
+// 2) --seed 54321 - run single simulation with seed 54321
+
+int main(int argc, const char** argv) {
+  int exit_code = matrix::Main(argc, argv, RunSimulation);
+  PrintAntiEntropyReport(std::cout);
+  return exit_code;
+}
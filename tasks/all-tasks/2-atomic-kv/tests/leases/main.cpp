@@ -0,0 +1,242 @@
+#include <kv/node/main.hpp>
+#include <kv/client/client.hpp>
+
+// Node
+#include <whirl/node/runtime/shortcuts.hpp>
+
+// Serialization
+#include <cereal/types/string.hpp>
+
+// Logging
+#include <timber/log.hpp>
+
+// Concurrency
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/sync/future.hpp>
+
+// Simulation
+#include <matrix/facade/world.hpp>
+#include <matrix/world/global/vars.hpp>
+#include <matrix/world/global/time.hpp>
+#include <matrix/client/rpc.hpp>
+#include <matrix/test/main.hpp>
+#include <matrix/test/event_log.hpp>
+#include <matrix/test/runner.hpp>
+
+#include <matrix/time_model/catalog/crazy.hpp>
+
+#include <matrix/fault/access.hpp>
+#include <matrix/fault/util.hpp>
+
+#include <matrix/semantics/printers/kv.hpp>
+#include <matrix/semantics/checker/check.hpp>
+#include <matrix/semantics/models/kv.hpp>
+
+#include <commute/rpc/id.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+using namespace whirl;
+
+//////////////////////////////////////////////////////////////////////
+
+// Writes racing read leases
+//
+// Readers hammer a single key, so coordinators hold read leases on its
+// range most of the time. Every write has to revoke the lease first, and
+// the adversary keeps pausing random nodes: when the paused node is the
+// holder, grantors wait the lease out by their clocks.
+//
+// Checks that reads stay linearizable and that writers are never stuck
+
+static const kv::Key kKey = "k";
+
+static const size_t kReplicas = 3;
+static const size_t kReaders = 3;
+
+static const uint64_t kLeaseDuration = 300;
+
+static const matrix::TimePoint kNoMoreFaults = 10000;
+static const Jiffies kTimeLimit = 30000_jfs;
+static const size_t kWritesThreshold = 20;
+
+//////////////////////////////////////////////////////////////////////
+
+// Longest write in all simulations, jiffies
+static uint64_t max_write_time = 0;
+
+//////////////////////////////////////////////////////////////////////
+
+[[noreturn]] void Reader() {
+  await::fibers::self::SetName("main");
+
+  node::rt::SleepFor(123_jfs);
+
+  timber::Logger logger_{"Reader", node::rt::LoggerBackend()};
+
+  kv::BlockingClient kv_store{matrix::client::MakeRpcChannel(
+      /*pool_name=*/"kv", /*port=*/42)};
+
+  while (true) {
+    LOG_INFO("Execute Get({})", kKey);
+    [[maybe_unused]] kv::Value result = kv_store.Get(kKey);
+    LOG_INFO("Get({}) -> {}", kKey, result);
+
+    // Keep the lease busy
+    node::rt::SleepFor(node::rt::RandomNumber(10, 50));
+  }
+}
+
+[[noreturn]] void Writer() {
+  await::fibers::self::SetName("main");
+
+  node::rt::SleepFor(123_jfs);
+
+  timber::Logger logger_{"Writer", node::rt::LoggerBackend()};
+
+  kv::BlockingClient kv_store{matrix::client::MakeRpcChannel(
+      /*pool_name=*/"kv", /*port=*/42)};
+
+  for (size_t i = 1;; ++i) {
+    auto value = std::to_string(i);
+
+    auto start = matrix::GlobalNow();
+    LOG_INFO("Execute Set({}, {})", kKey, value);
+    kv_store.Set(kKey, value);
+    LOG_INFO("Set completed");
+    max_write_time =
+        std::max<uint64_t>(max_write_time, matrix::GlobalNow() - start);
+
+    matrix::GlobalCounter("writes").Increment();
+
+    // Let readers take the lease again
+    node::rt::SleepFor(node::rt::RandomNumber(50, 200));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Pauses make lease holders unreachable for revocation
+void PauseAdversary() {
+  timber::Logger logger_{"Pause-Adversary", node::rt::LoggerBackend()};
+
+  auto pool = node::rt::Discovery()->ListPool("kv");
+
+  while (matrix::GlobalNow() < kNoMoreFaults) {
+    matrix::fault::RandomPause(100_jfs, 500_jfs);
+
+    auto& victim = matrix::fault::RandomServer(pool);
+
+    // Shorter and longer than the lease
+    victim.Pause();
+    matrix::fault::RandomPause(50_jfs, Jiffies{2 * kLeaseDuration});
+    victim.Resume();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Sequential specification for KV storage
+// Used by linearizability checker
+using KVStoreModel = semantics::KVStoreModel<kv::Key, kv::Value>;
+
+//////////////////////////////////////////////////////////////////////
+
+// Seed -> simulation digest
+// Deterministic
+size_t RunSimulation(size_t seed) {
+  auto& runner = matrix::TestRunner::Access();
+
+  runner.Verbose() << "Simulation seed: " << seed << std::endl;
+
+  // Reset RPC ids
+  commute::rpc::ResetIds();
+
+  matrix::facade::World world{seed};
+
+  // Time model
+  world.SetTimeModel(matrix::MakeCrazyTimeModel());
+
+  // Cluster
+  world.MakePool("kv", KVNodeMain).Size(kReplicas);
+
+  // Clients
+  world.AddClients(Reader, /*count=*/kReaders);
+  world.AddClients(Writer, /*count=*/1);
+
+  world.AddAdversary(PauseAdversary);
+
+  // Log file
+
+  if (auto path = runner.LogFile()) {
+    world.WriteLogTo(*path);
+  }
+
+  // Globals
+  world.InitCounter("writes", 0);
+
+  world.SetGlobal<int64_t>("config.kv.anti_entropy.period", 500);
+  world.SetGlobal<int64_t>("config.kv.anti_entropy.batch", 16);
+  world.SetGlobal<int64_t>("config.kv.lease.duration",
+                           (int64_t)kLeaseDuration);
+  world.SetGlobal<int64_t>("config.kv.chunk_size", 64);
+
+  // Run simulation
+
+  world.Start();
+  while (world.GetCounter("writes") < kWritesThreshold &&
+         world.TimeElapsed() < kTimeLimit) {
+    if (!world.Step()) {
+      break;  // Deadlock
+    }
+  }
+
+  size_t digest = world.Stop();
+
+  runner.Verbose() << "Seed " << seed << " -> "
+                   << "digest: " << digest << ", time: " << world.TimeElapsed()
+                   << ", writes: " << world.GetCounter("writes") << std::endl;
+
+  const auto event_log = world.EventLog();
+
+  // Writer is stuck behind a lease
+  if (world.GetCounter("writes") < kWritesThreshold) {
+    runner.Report() << "Log:" << std::endl;
+    matrix::WriteTextLog(event_log, runner.Report());
+    runner.Report() << std::endl;
+
+    runner.Report() << "Writes completed: " << world.GetCounter("writes")
+                    << " < " << kWritesThreshold << " for seed = " << seed
+                    << std::endl;
+    runner.Fail();
+  }
+
+  // Check linearizability
+  const auto history = world.History();
+  const bool linearizable = semantics::LinCheck<KVStoreModel>(history);
+
+  if (!linearizable) {
+    runner.Verbose() << "Log:" << std::endl;
+    matrix::WriteTextLog(event_log, runner.Verbose());
+    runner.Verbose() << std::endl;
+
+    runner.Report() << "History is NOT LINEARIZABLE for seed = " << seed << ":"
+                    << std::endl;
+    semantics::PrintKVHistory<kv::Key, kv::Value>(history, runner.Report());
+
+    runner.Fail();
+  }
+
+  return digest;
+}
+
+// Usage:
+// 1) --det --sims 1000 - check determinism and run 1000 simulations
+// 2) --seed 54321 - run single simulation with seed 54321
+
+int main(int argc, const char** argv) {
+  int exit_code = matrix::Main(argc, argv, RunSimulation);
+  std::cout << "Longest write: " << max_write_time << " jiffies" << std::endl;
+  return exit_code;
+}
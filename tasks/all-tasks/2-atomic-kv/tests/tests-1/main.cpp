@@ -254,6 +254,13 @@ size_t RunSimulation(size_t seed) {
   world.SetGlobal("keys", keys);
   world.InitCounter("requests", 0);
 
+  // Anti-entropy
+  world.SetGlobal<int64_t>("config.kv.anti_entropy.period", 500);
+  world.SetGlobal<int64_t>("config.kv.anti_entropy.batch", 16);
+  world.SetGlobal<int64_t>("config.kv.lease.duration", 300);
+  // Exercise chunked transfer: two-digit values are split
+  world.SetGlobal<int64_t>("config.kv.chunk_size", 1);
+
   // Run simulation
 
   world.Start();
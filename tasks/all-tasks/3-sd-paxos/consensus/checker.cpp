@@ -1,58 +1,74 @@
 #include <consensus/checker.hpp>
 
-#include <consensus/value.hpp>
-
-#include <set>
+#include <utility>
 
 namespace consensus {
 
 //////////////////////////////////////////////////////////////////////
 
-class SafetyChecker {
- public:
-  explicit SafetyChecker(const whirl::semantics::History& history) {
-    Load(history);
-  }
+void StreamingChecker::Propose(const Value& input) {
+  inputs_.insert(input);
+  Record("Propose(" + input + ")");
+}
 
-  bool Safe() const {
-    return Agreement() && Validity();
+bool StreamingChecker::Decide(const Value& output) {
+  if (!Safe()) {
+    return false;
   }
 
-  bool Agreement() const {
-    return outputs_.size() == 1;
+  Record("Decided: " + output);
+
+  // Agreement
+  if (chosen_.has_value() && *chosen_ != output) {
+    violation_ = "Agreement violated: " + *chosen_ + " != " + output;
+    return false;
   }
 
-  bool Validity() const {
-    if (outputs_.empty()) {
-      return true;
-    }
-    const Value output = *outputs_.begin();
-    return inputs_.count(output) > 0;
+  // Validity
+  if (inputs_.count(output) == 0) {
+    violation_ = "Validity violated: " + output + " was never proposed";
+    return false;
   }
 
- private:
-  void Load(const whirl::semantics::History& history) {
-    for (const auto& call : history) {
-      auto [input] = call.arguments.As<Value>();
-      inputs_.insert(input);
+  chosen_ = output;
+  return true;
+}
 
-      if (call.IsCompleted()) {
-        auto output = call.result->As<Value>();
-        outputs_.insert(output);
-      }
-    }
-  }
+void StreamingChecker::Reset() {
+  inputs_.clear();
+  chosen_.reset();
+  violation_.reset();
+  tail_.clear();
+}
 
- private:
-  std::set<Value> inputs_;
-  std::set<Value> outputs_;
-};
+void StreamingChecker::Record(std::string event) {
+  if (tail_.size() == kTailSize) {
+    tail_.pop_front();
+  }
+  tail_.push_back(std::move(event));
+}
 
 //////////////////////////////////////////////////////////////////////
 
 bool IsSafe(const whirl::semantics::History& history) {
-  SafetyChecker checker(history);
-  return checker.Safe();
+  StreamingChecker checker;
+
+  // Chosen value could be proposed by a call started after
+  // the completion of another one in history order
+  for (const auto& call : history) {
+    auto [input] = call.arguments.As<Value>();
+    checker.Propose(input);
+  }
+
+  for (const auto& call : history) {
+    if (call.IsCompleted()) {
+      if (!checker.Decide(call.result->As<Value>())) {
+        return false;
+      }
+    }
+  }
+
+  return checker.Decided();
 }
 
 }   // namespace consensus
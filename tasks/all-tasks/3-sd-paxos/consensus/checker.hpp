@@ -1,9 +1,66 @@
 #pragma once
 
+#include <consensus/value.hpp>
+
 #include <matrix/semantics/history.hpp>
 
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <string>
+#include <unordered_set>
+
 namespace consensus {
 
+// Incremental checker of consensus safety properties
+//
+// Consumes Propose calls as they start and complete, keeps only
+// the chosen value, the set of proposed inputs and a bounded tail
+// of recent events for failure reports.
+// Stops at the first violation
+
+class StreamingChecker {
+ public:
+  // Propose(input) started
+  void Propose(const Value& input);
+
+  // Propose completed with `output`
+  // Returns false on agreement / validity violation
+  bool Decide(const Value& output);
+
+  bool Safe() const {
+    return !violation_.has_value();
+  }
+
+  // At least one Propose completed
+  bool Decided() const {
+    return chosen_.has_value();
+  }
+
+  // Description of the first violation
+  const std::string& Violation() const {
+    return *violation_;
+  }
+
+  // Last kTailSize events, oldest first
+  const std::deque<std::string>& Tail() const {
+    return tail_;
+  }
+
+  void Reset();
+
+ private:
+  void Record(std::string event);
+
+ private:
+  static const size_t kTailSize = 64;
+
+  std::unordered_set<Value> inputs_;
+  std::optional<Value> chosen_;
+  std::optional<std::string> violation_;
+  std::deque<std::string> tail_;
+};
+
 // Checks safety properties of consensus
 bool IsSafe(const whirl::semantics::History& history);
 
@@ -1,24 +1,195 @@
 #include <paxos/node/acceptor.hpp>
+#include <paxos/node/fast.hpp>
 
 #include <whirl/node/runtime/shortcuts.hpp>
 
+#include <await/fibers/core/await.hpp>
+
 #include <timber/log.hpp>
 
+#include <mutex>
+
 using namespace whirl;
 
 namespace paxos {
 
-Acceptor::Acceptor() : logger_("Paxos.Acceptor", node::rt::LoggerBackend()) {
+static const std::string kStateKey = "state";
+
+Acceptor::Acceptor()
+    : store_(node::rt::Database(), "acceptor"),
+      logger_("Paxos.Acceptor", node::rt::LoggerBackend()) {
+  state_ = store_.GetOr(kStateKey, State{});
+}
+
+void Acceptor::Prepare(const proto::Prepare::Request& request,
+                       proto::Prepare::Response* response) {
+  uint64_t version;
+
+  {
+    auto guard = mutex_.Guard();
+
+    // Repeated Prepare with the same number is acknowledged again
+    if (request.n < state_.promise) {
+      LOG_INFO("Reject Prepare({}), promise: {}", request.n, state_.promise);
+      response->ack = false;
+      response->advice = state_.promise;
+      return;
+    }
+
+    // Do not rewrite unchanged state
+    if (state_.promise < request.n) {
+      state_.promise = request.n;
+      ++version_;
+    }
+
+    LOG_INFO("Promise {}, vote: {}", request.n, state_.vote.has_value());
+
+    response->ack = true;
+    response->advice = state_.promise;
+    response->vote = state_.vote;
+
+    version = version_;
+  }
+
+  // Promise (and reported vote) should survive restart
+  WaitDurable(version);
+}
+
+void Acceptor::Accept(const proto::Accept::Request& request,
+                      proto::Accept::Response* response) {
+  uint64_t version;
+
+  {
+    auto guard = mutex_.Guard();
+
+    const auto& proposal = request.proposal;
+
+    if (proposal.n < state_.promise) {
+      LOG_INFO("Reject Accept({}), promise: {}", proposal, state_.promise);
+      response->ack = false;
+      response->advice = state_.promise;
+      return;
+    }
+
+    // Retried Accept does not change state
+    bool same_vote = state_.vote.has_value() && state_.vote->n == proposal.n &&
+                     state_.vote->value == proposal.value;
+
+    if (!same_vote || state_.promise != proposal.n) {
+      LOG_INFO("Accept {}", proposal);
+
+      state_.promise = proposal.n;
+      state_.vote = proposal;
+      ++version_;
+    }
+
+    response->ack = true;
+    response->advice = state_.promise;
+
+    version = version_;
+  }
+
+  WaitDurable(version);
 }
 
-void Acceptor::Prepare(const proto::Prepare::Request& /*request*/,
-                       proto::Prepare::Response* /*response*/) {
-  // Your code goes here
+void Acceptor::FastAccept(const proto::FastAccept::Request& request,
+                          proto::FastAccept::Response* response) {
+  uint64_t version;
+
+  {
+    auto guard = mutex_.Guard();
+
+    // Fast round is over for this acceptor
+    if (FastRound() < state_.promise) {
+      response->ack = false;
+      response->advice = state_.promise;
+      return;
+    }
+
+    if (!state_.vote.has_value()) {
+      LOG_INFO("Vote for {} in the fast round", request.value);
+
+      state_.vote = Proposal{FastRound(), request.value};
+      ++version_;
+    } else if (state_.vote->value != request.value) {
+      // Collision: one vote per round
+      response->ack = false;
+      response->advice = state_.promise;
+      return;
+    }
+
+    response->ack = true;
+    response->advice = state_.promise;
+
+    version = version_;
+  }
+
+  WaitDurable(version);
 }
 
-void Acceptor::Accept(const proto::Accept::Request& /*request*/,
-                      proto::Accept::Response* /*response*/) {
-  // Your code goes here
+void Acceptor::WaitDurable(uint64_t version) {
+  std::unique_lock lock(mutex_);
+
+  if (durable_version_ >= version) {
+    return;
+  }
+
+  if (flushing_) {
+    // Will be released by the current flusher
+    auto [future, promise] = await::futures::MakeContract<void>();
+    waiters_.emplace_back(version, std::move(promise));
+    lock.unlock();
+
+    await::fibers::Await(std::move(future)).ExpectOk();
+    return;
+  }
+
+  // Become the flusher
+  flushing_ = true;
+
+  while (true) {
+    State snapshot = state_;
+    uint64_t snapshot_version = version_;
+
+    lock.unlock();
+    store_.Put(kStateKey, snapshot);
+    lock.lock();
+
+    durable_version_ = snapshot_version;
+
+    std::vector<await::futures::Promise<void>> ready;
+    std::vector<std::pair<uint64_t, await::futures::Promise<void>>> pending;
+
+    for (auto& [waiter_version, promise] : waiters_) {
+      if (waiter_version <= durable_version_) {
+        ready.push_back(std::move(promise));
+      } else {
+        pending.emplace_back(waiter_version, std::move(promise));
+      }
+    }
+    waiters_ = std::move(pending);
+
+    // Updates made during the write need another one
+    bool done = waiters_.empty();
+    if (done) {
+      flushing_ = false;
+    }
+
+    lock.unlock();
+
+    if (!ready.empty()) {
+      LOG_INFO("Flushed state for {} waiting replies", ready.size() + 1);
+    }
+    for (auto& promise : ready) {
+      std::move(promise).SetValue();
+    }
+
+    if (done) {
+      return;
+    }
+
+    lock.lock();
+  }
 }
 
 }  // namespace paxos
@@ -5,8 +5,19 @@
 
 #include <commute/rpc/service_base.hpp>
 
+#include <whirl/node/store/kv.hpp>
+
+#include <await/fibers/sync/mutex.hpp>
+#include <await/futures/core/future.hpp>
+
+#include <muesli/serializable.hpp>
+
 #include <timber/logger.hpp>
 
+#include <optional>
+#include <utility>
+#include <vector>
+
 namespace paxos {
 
 // Acceptor role / RPC service
@@ -19,6 +30,7 @@ class Acceptor : public commute::rpc::ServiceBase<Acceptor> {
   void RegisterMethods() override {
     COMMUTE_RPC_REGISTER_HANDLER(Prepare);
     COMMUTE_RPC_REGISTER_HANDLER(Accept);
+    COMMUTE_RPC_REGISTER_HANDLER(FastAccept);
   }
 
   // Phase 1 (Prepare / Promise)
@@ -31,7 +43,43 @@ class Acceptor : public commute::rpc::ServiceBase<Acceptor> {
   void Accept(const proto::Accept::Request& request,
               proto::Accept::Response* response);
 
+  // Fast round (Fast Paxos)
+
+  void FastAccept(const proto::FastAccept::Request& request,
+                  proto::FastAccept::Response* response);
+
+ private:
+  // Durable acceptor state
+  struct State {
+    // Do not accept proposals with numbers < promise
+    ProposalNumber promise = ProposalNumber::Zero();
+    // Last accepted proposal
+    std::optional<Proposal> vote;
+
+    MUESLI_SERIALIZABLE(promise, vote)
+  };
+
+  // Group commit
+  //
+  // Handlers update in-memory state and bump its version, then wait
+  // until some version >= theirs is durable. Single flusher at a time
+  // writes the latest state, so concurrent updates share one write
+
+  // Without mutex
+  void WaitDurable(uint64_t version);
+
  private:
+  whirl::node::store::KVStore<State> store_;
+
+  await::fibers::Mutex mutex_;
+  // In-memory state, replies are released when it is durable
+  State state_;
+
+  uint64_t version_ = 0;
+  uint64_t durable_version_ = 0;
+  bool flushing_ = false;
+  std::vector<std::pair<uint64_t, await::futures::Promise<void>>> waiters_;
+
   timber::Logger logger_;
 };
 
@@ -1,7 +1,33 @@
 #include <paxos/node/backoff.hpp>
 
+#include <whirl/node/runtime/shortcuts.hpp>
+
+#include <algorithm>
+
+using namespace whirl;
+
 namespace paxos {
 
-// Your code goes here
+Backoff::Params Backoff::Params::FromConfig() {
+  auto config = node::rt::Config();
+  return {config->GetInt<uint64_t>("paxos.backoff.init"),
+          config->GetInt<uint64_t>("paxos.backoff.max"),
+          config->GetInt<uint64_t>("paxos.backoff.factor")};
+}
+
+Backoff::Backoff(Params params) : params_(params), delay_(params.init) {
+}
+
+Jiffies Backoff::Next() {
+  uint64_t delay = delay_;
+  delay_ = std::min(delay_ * params_.factor, params_.max);
+
+  // Equal jitter
+  return delay / 2 + node::rt::RandomNumber(delay / 2 + 1);
+}
+
+void Backoff::Reset() {
+  delay_ = params_.init;
+}
 
 }  // namespace paxos
@@ -0,0 +1,39 @@
+#include <paxos/node/fast.hpp>
+
+#include <wheels/support/panic.hpp>
+
+#include <map>
+
+namespace paxos {
+
+void CheckFastQuorums(const QuorumSizes& quorums, size_t nodes) {
+  if (quorums.phase1 + 2 * FastQuorumSize(nodes) <= 2 * nodes) {
+    WHEELS_PANIC("Phase 1 quorum does not intersect two fast quorums");
+  }
+}
+
+std::optional<Value> RecoverFastValue(
+    const std::vector<proto::Prepare::Response>& promises, size_t nodes) {
+  std::map<Value, size_t> votes;
+
+  for (const auto& promise : promises) {
+    if (promise.vote.has_value() && promise.vote->n == FastRound()) {
+      ++votes[promise.vote->value];
+    }
+  }
+
+  // Fast quorum that chose the value intersects our quorum in
+  // at least Q1 + F - N acceptors, all of them voted for the value.
+  // Q1 + 2F > 2N guarantees at most one such value
+  size_t threshold = promises.size() + FastQuorumSize(nodes) - nodes;
+
+  for (const auto& [value, count] : votes) {
+    if (count >= threshold) {
+      return value;
+    }
+  }
+
+  return std::nullopt;
+}
+
+}  // namespace paxos
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <paxos/node/proposal.hpp>
+#include <paxos/node/proto.hpp>
+#include <paxos/node/quorum.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace paxos {
+
+// Fast Paxos
+//
+// Fast round has the lowest proposal number, so no Phase 1 is needed
+// to open it: values are sent directly to acceptors, every acceptor
+// votes for the first value it receives. Value is chosen iff a fast
+// quorum voted for it. Collisions are resolved by classic rounds > 0
+
+inline ProposalNumber FastRound() {
+  return ProposalNumber::Zero();
+}
+
+// ceil(3N / 4)
+inline size_t FastQuorumSize(size_t nodes) {
+  return (3 * nodes + 3) / 4;
+}
+
+// Any Phase 1 quorum should intersect any two fast quorums:
+// Q1 + 2F > 2N, panics otherwise
+void CheckFastQuorums(const QuorumSizes& quorums, size_t nodes);
+
+// Value that could have been chosen in the fast round, judging by
+// the fast round votes reported by a Phase 1 quorum
+std::optional<Value> RecoverFastValue(
+    const std::vector<proto::Prepare::Response>& promises, size_t nodes);
+
+}  // namespace paxos
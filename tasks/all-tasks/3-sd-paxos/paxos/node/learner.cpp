@@ -0,0 +1,75 @@
+#include <paxos/node/learner.hpp>
+
+#include <whirl/node/runtime/shortcuts.hpp>
+
+#include <commute/rpc/call.hpp>
+
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/core/await.hpp>
+#include <await/fibers/sync/future.hpp>
+
+#include <timber/log.hpp>
+
+using namespace whirl;
+
+namespace paxos {
+
+static const std::string kDecisionKey = "decision";
+
+Learner::Learner()
+    : Peer(node::rt::Config()),
+      store_(node::rt::Database(), "learner"),
+      logger_("Paxos.Learner", node::rt::LoggerBackend()) {
+  decision_ = store_.TryGet(kDecisionKey);
+}
+
+std::optional<Value> Learner::TryGetDecision() {
+  auto guard = mutex_.Guard();
+  return decision_;
+}
+
+void Learner::Announce(Value chosen) {
+  Learn(chosen);
+  Broadcast(std::move(chosen));
+}
+
+void Learner::CountCacheHit() {
+  uint64_t hits = ++cache_hits_;
+  LOG_INFO("Proposal answered from decision cache ({} total)", hits);
+}
+
+void Learner::Learn(Value chosen) {
+  auto guard = mutex_.Guard();
+
+  if (decision_.has_value()) {
+    return;  // Chosen value never changes
+  }
+
+  LOG_INFO("Learned chosen value: {}", chosen);
+
+  store_.Put(kDecisionKey, chosen);
+  decision_ = std::move(chosen);
+}
+
+uint64_t Learner::CacheHits() {
+  return cache_hits_.load();
+}
+
+void Learner::Broadcast(Value chosen) {
+  for (const auto& peer : ListPeers().WithoutMe()) {
+    await::fibers::Go([this, peer, chosen]() {
+      auto ack = await::fibers::Await(commute::rpc::Call("Learner.Learn")
+                                          .Args(chosen)
+                                          .Via(Channel(peer))
+                                          .Context(await::context::ThisFiber())
+                                          .AtLeastOnce()
+                                          .Start()
+                                          .As<void>());
+      if (!ack.IsOk()) {
+        LOG_INFO("Failed to deliver decision to {}", peer);
+      }
+    });
+  }
+}
+
+}  // namespace paxos
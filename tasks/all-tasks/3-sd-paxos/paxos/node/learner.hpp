@@ -1,7 +1,67 @@
 #pragma once
 
+#include <paxos/node/proposal.hpp>
+
+#include <commute/rpc/service_base.hpp>
+
+#include <whirl/node/cluster/peer.hpp>
+#include <whirl/node/store/kv.hpp>
+
+#include <await/fibers/sync/mutex.hpp>
+
+#include <timber/logger.hpp>
+
+#include <atomic>
+#include <optional>
+
 namespace paxos {
 
-// Your learner code goes here
+// Learner role / RPC service
+//
+// Durably remembers the chosen value once a proposer observed
+// an Accept quorum, so that later Propose calls are answered
+// without running the protocol
+
+class Learner : public commute::rpc::ServiceBase<Learner>,
+                public whirl::node::cluster::Peer {
+ public:
+  Learner();
+
+  // Local access from Proposer
+
+  std::optional<Value> TryGetDecision();
+
+  // Record decision locally and broadcast it to the other nodes
+  void Announce(Value chosen);
+
+  // Proposals answered from the decision cache
+  void CountCacheHit();
+
+ protected:
+  void RegisterMethods() override {
+    COMMUTE_RPC_REGISTER_METHOD(Learn);
+    COMMUTE_RPC_REGISTER_METHOD(CacheHits);
+  }
+
+  // RPC handlers
+
+  void Learn(Value chosen);
+
+  uint64_t CacheHits();
+
+ private:
+  void Broadcast(Value chosen);
+
+ private:
+  whirl::node::store::KVStore<Value> store_;
+
+  await::fibers::Mutex mutex_;
+  // Cached durable decision
+  std::optional<Value> decision_;
+
+  std::atomic<uint64_t> cache_hits_{0};
+
+  timber::Logger logger_;
+};
 
 }  // namespace paxos
@@ -14,7 +14,29 @@ using namespace whirl;
 namespace paxos {
 
 void NodeMain() {
-  // Your code goes here
+  node::rt::PrintLine("Starting at {}", node::rt::WallTimeNow());
+
+  // Open local database (acceptor state, decision)
+
+  auto db_path = node::rt::Config()->GetString("db.path");
+  node::rt::Database()->Open(db_path);
+
+  // Start RPC server
+
+  auto rpc_port = node::rt::Config()->GetInt<uint16_t>("rpc.port");
+  auto rpc_server = node::rpc::MakeServer(rpc_port);
+
+  auto learner = std::make_shared<Learner>();
+
+  rpc_server->RegisterService("Acceptor", std::make_shared<Acceptor>());
+  rpc_server->RegisterService("Learner", learner);
+  rpc_server->RegisterService("Proposer", std::make_shared<Proposer>(learner));
+
+  rpc_server->Start();
+
+  // Serving ...
+
+  await::futures::BlockForever();
 }
 
 }  // namespace paxos
@@ -7,6 +7,7 @@
 
 #include <string>
 #include <ostream>
+#include <tuple>
 
 namespace paxos {
 
@@ -16,24 +17,35 @@ using Value = std::string;
 
 ////////////////////////////////////////////////////////////////////////////////
 
-// Proposal number
+// Proposal number = (round, node)
+// Node id breaks ties between proposers running the same round,
+// so distinct proposers never share a proposal number
 
 struct ProposalNumber {
-  uint64_t k = 0;
+  uint64_t round = 0;
+  std::string node;
 
   static ProposalNumber Zero() {
-    return {0};
+    return {0, ""};
   }
 
   bool operator<(const ProposalNumber& that) const {
-    return k < that.k;
+    return std::tie(round, node) < std::tie(that.round, that.node);
   }
 
-  MUESLI_SERIALIZABLE(k)
+  bool operator==(const ProposalNumber& that) const {
+    return round == that.round && node == that.node;
+  }
+
+  bool operator!=(const ProposalNumber& that) const {
+    return !(*this == that);
+  }
+
+  MUESLI_SERIALIZABLE(round, node)
 };
 
 inline std::ostream& operator<<(std::ostream& out, const ProposalNumber& n) {
-  out << "{" << n.k << "}";
+  out << "{" << n.round << ", " << n.node << "}";
   return out;
 }
 
@@ -1,19 +1,223 @@
 #include <paxos/node/proposer.hpp>
+#include <paxos/node/backoff.hpp>
 
 #include <whirl/node/runtime/shortcuts.hpp>
 
+#include <commute/rpc/call.hpp>
+
+#include <await/fibers/core/await.hpp>
+#include <await/fibers/sync/future.hpp>
+
 #include <timber/log.hpp>
 
+#include <algorithm>
+
 using namespace whirl;
 
 namespace paxos {
 
-Proposer::Proposer() : logger_("Paxos.Proposer", node::rt::LoggerBackend()) {
+static const std::string kFirstRoundKey = "first_round_used";
+static const std::string kRoundKey = "round";
+
+Proposer::Proposer(std::shared_ptr<Learner> learner)
+    : Peer(node::rt::Config()),
+      learner_(std::move(learner)),
+      quorums_(ConfigureQuorums(NodeCount())),
+      fast_(node::rt::Config()->GetInt<int64_t>("paxos.fast") != 0),
+      fast_timeout_(node::rt::Config()->GetInt<uint64_t>("paxos.fast_timeout")),
+      optimistic_(node::rt::Config()->GetInt<int64_t>("paxos.optimistic") != 0),
+      store_(node::rt::Database(), "proposer"),
+      round_store_(node::rt::Database(), "proposer.round"),
+      logger_("Paxos.Proposer", node::rt::LoggerBackend()) {
+  first_round_used_ = store_.GetOr(kFirstRoundKey, false);
+  max_round_ = round_store_.GetOr(kRoundKey, 0);
+
+  if (fast_) {
+    CheckFastQuorums(quorums_, NodeCount());
+  }
 }
 
 Value Proposer::Propose(Value input) {
-  return input;  // Violates agreement
-  // return 0;  // Violates validity
+  if (auto chosen = learner_->TryGetDecision()) {
+    learner_->CountCacheHit();
+    return *chosen;
+  }
+
+  if (fast_) {
+    // Skip the coordinator, send value directly to acceptors
+    if (RunFastAccept(input).ok) {
+      LOG_INFO("Chosen in the fast round: {}", input);
+      learner_->Announce(input);
+      return input;
+    }
+
+    // Collision, recover in classic rounds
+    LOG_INFO("Fast round collided");
+  } else if (optimistic_ && IsDistinguished() && TryClaimFirstRound()) {
+    // Phase 2 right away
+    Proposal proposal{{0, node::rt::HostName()}, input};
+
+    if (RunAccept(proposal).ok) {
+      LOG_INFO("Chosen in the first round: {}", proposal);
+      learner_->Announce(proposal.value);
+      return proposal.value;
+    }
+
+    // Fall back to the full protocol with rounds > 0
+    LOG_INFO("First round rejected");
+  }
+
+  Backoff backoff{Backoff::Params::FromConfig()};
+
+  while (true) {
+    auto n = NextProposalNumber();
+
+    // Phase 1
+
+    auto promises = RunPrepare(n);
+
+    if (promises.ok) {
+      Proposal proposal{n, ChooseValue(promises.acks, input)};
+
+      // Phase 2
+
+      auto accepted = RunAccept(proposal);
+
+      if (accepted.ok) {
+        LOG_INFO("Chosen: {}", proposal);
+        learner_->Announce(proposal.value);
+        return proposal.value;
+      }
+
+      AdoptAdvice(accepted.advice);
+    } else {
+      AdoptAdvice(promises.advice);
+    }
+
+    // Give the competing proposer a chance to complete
+    auto delay = backoff.Next();
+    LOG_INFO("Proposal {} failed, retry after {} jiffies", n, delay.Count());
+    node::rt::SleepFor(delay);
+  }
+}
+
+QuorumOutcome<proto::Prepare> Proposer::RunPrepare(const ProposalNumber& n) {
+  std::vector<await::futures::Future<proto::Prepare::Response>> promises;
+
+  for (const auto& peer : ListPeers().WithMe()) {
+    promises.push_back(  //
+        commute::rpc::Call("Acceptor.Prepare")
+            .Args(proto::Prepare::Request{n})
+            .Via(Channel(peer))
+            .Context(await::context::ThisFiber())
+            .AtLeastOnce()
+            .Start()
+            .As<proto::Prepare::Response>());
+  }
+
+  return await::fibers::Await(
+             PhaseQuorum<proto::Prepare>(std::move(promises), quorums_.phase1))
+      .ValueOrThrow();
+}
+
+QuorumOutcome<proto::Accept> Proposer::RunAccept(const Proposal& proposal) {
+  std::vector<await::futures::Future<proto::Accept::Response>> votes;
+
+  for (const auto& peer : ListPeers().WithMe()) {
+    votes.push_back(  //
+        commute::rpc::Call("Acceptor.Accept")
+            .Args(proto::Accept::Request{proposal})
+            .Via(Channel(peer))
+            .Context(await::context::ThisFiber())
+            .AtLeastOnce()
+            .Start()
+            .As<proto::Accept::Response>());
+  }
+
+  return await::fibers::Await(
+             PhaseQuorum<proto::Accept>(std::move(votes), quorums_.phase2))
+      .ValueOrThrow();
+}
+
+QuorumOutcome<proto::FastAccept> Proposer::RunFastAccept(const Value& value) {
+  std::vector<await::futures::Future<proto::FastAccept::Response>> votes;
+
+  for (const auto& peer : ListPeers().WithMe()) {
+    votes.push_back(  //
+        commute::rpc::Call("Acceptor.FastAccept")
+            .Args(proto::FastAccept::Request{value})
+            .Via(Channel(peer))
+            .Context(await::context::ThisFiber())
+            .AtLeastOnce()
+            .Start()
+            .As<proto::FastAccept::Response>());
+  }
+
+  auto fast_quorum =
+      PhaseQuorum<proto::FastAccept>(std::move(votes), FastQuorumSize(NodeCount()));
+
+  // Fast quorum tolerates fewer failures than the classic one,
+  // do not wait for it forever
+  return await::fibers::Await(WithTimeout(std::move(fast_quorum), fast_timeout_))
+      .ValueOrThrow();
+}
+
+Value Proposer::ChooseValue(
+    const std::vector<proto::Prepare::Response>& promises, Value input) {
+  std::optional<Proposal> latest;
+
+  for (const auto& promise : promises) {
+    if (promise.vote.has_value() &&
+        (!latest.has_value() || latest->n < promise.vote->n)) {
+      latest = promise.vote;
+    }
+  }
+
+  if (!latest.has_value()) {
+    return input;
+  }
+
+  if (latest->n == FastRound()) {
+    // Acceptors may report different fast round votes
+    return RecoverFastValue(promises, NodeCount()).value_or(input);
+  }
+
+  return latest->value;
+}
+
+bool Proposer::IsDistinguished() {
+  auto peers = ListPeers().WithMe();
+  return node::rt::HostName() == *std::min_element(peers.begin(), peers.end());
+}
+
+bool Proposer::TryClaimFirstRound() {
+  auto guard = first_round_mutex_.Guard();
+
+  if (first_round_used_) {
+    return false;
+  }
+
+  // Persist before sending Accept: after restart round 0 could
+  // otherwise be reused with a different value
+  first_round_used_ = true;
+  store_.Put(kFirstRoundKey, true);
+
+  return true;
+}
+
+ProposalNumber Proposer::NextProposalNumber() {
+  auto guard = round_mutex_.Guard();
+  // Persist before sending Prepare: after restart {round, host}
+  // could otherwise be reused with a different value
+  ++max_round_;
+  round_store_.Put(kRoundKey, max_round_);
+  return {max_round_, node::rt::HostName()};
+}
+
+void Proposer::AdoptAdvice(const ProposalNumber& advice) {
+  auto guard = round_mutex_.Guard();
+  // Persisted with the next proposal number
+  max_round_ = std::max(max_round_, advice.round);
 }
 
 }  // namespace paxos
@@ -2,18 +2,29 @@
 
 #include <paxos/node/proposal.hpp>
 #include <paxos/node/proto.hpp>
+#include <paxos/node/learner.hpp>
+#include <paxos/node/quorum.hpp>
+#include <paxos/node/fast.hpp>
 
 #include <commute/rpc/service_base.hpp>
 
+#include <whirl/node/cluster/peer.hpp>
+#include <whirl/node/store/kv.hpp>
+
+#include <await/fibers/sync/mutex.hpp>
+
 #include <timber/logger.hpp>
 
+#include <memory>
+
 namespace paxos {
 
 // Proposer role / RPC service
 
-class Proposer : public commute::rpc::ServiceBase<Proposer> {
+class Proposer : public commute::rpc::ServiceBase<Proposer>,
+                 public whirl::node::cluster::Peer {
  public:
-  Proposer();
+  explicit Proposer(std::shared_ptr<Learner> learner);
 
  protected:
   void RegisterMethods() override {
@@ -23,6 +34,53 @@ class Proposer : public commute::rpc::ServiceBase<Proposer> {
   Value Propose(Value input);
 
  private:
+  // Phases
+
+  QuorumOutcome<proto::Prepare> RunPrepare(const ProposalNumber& n);
+  QuorumOutcome<proto::Accept> RunAccept(const Proposal& proposal);
+  QuorumOutcome<proto::FastAccept> RunFastAccept(const Value& value);
+
+  // Optimistic first round
+
+  // Round 0 belongs to the distinguished proposer and is used at most once,
+  // no lower proposal number exists, so Phase 1 can be skipped
+  bool TryClaimFirstRound();
+  bool IsDistinguished();
+
+  // Value of the highest-numbered vote or our own input
+  Value ChooseValue(const std::vector<proto::Prepare::Response>& promises,
+                    Value input);
+
+  // Proposal numbers
+
+  // Fresh number, greater than any number observed on this node
+  ProposalNumber NextProposalNumber();
+  // Jump ahead of the number reported by acceptors
+  void AdoptAdvice(const ProposalNumber& advice);
+
+ private:
+  // Decision cache
+  std::shared_ptr<Learner> learner_;
+
+  const QuorumSizes quorums_;
+
+  // paxos.fast
+  const bool fast_;
+  // paxos.fast_timeout
+  const whirl::Jiffies fast_timeout_;
+  // paxos.optimistic
+  const bool optimistic_;
+  // Persistent "first round used" flag
+  whirl::node::store::KVStore<bool> store_;
+  await::fibers::Mutex first_round_mutex_;
+  bool first_round_used_;
+
+  // Shared by concurrent Propose calls on this node
+  // Persistent: proposal numbers are never reused after restart
+  whirl::node::store::KVStore<uint64_t> round_store_;
+  await::fibers::Mutex round_mutex_;
+  uint64_t max_round_;
+
   timber::Logger logger_;
 };
 
@@ -55,6 +55,27 @@ struct Accept {
   };
 };
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Fast round
+
+struct FastAccept {
+  // Value sent directly to acceptors
+  struct Request {
+    Value value;
+
+    MUESLI_SERIALIZABLE(value)
+  };
+
+  // Voted
+  struct Response {
+    bool ack = false;
+    ProposalNumber advice;
+
+    MUESLI_SERIALIZABLE(ack, advice)
+  };
+};
+
 }  // namespace proto
 
 }  // namespace paxos
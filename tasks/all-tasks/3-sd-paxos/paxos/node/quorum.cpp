@@ -0,0 +1,33 @@
+#include <paxos/node/quorum.hpp>
+
+#include <whirl/node/runtime/shortcuts.hpp>
+
+#include <wheels/support/panic.hpp>
+
+using namespace whirl;
+
+namespace paxos {
+
+static size_t QuorumSize(const std::string& key, size_t nodes) {
+  size_t size = node::rt::Config()->GetInt<size_t>(key);
+  if (size == 0) {
+    return nodes / 2 + 1;  // Majority
+  }
+  return size;
+}
+
+QuorumSizes ConfigureQuorums(size_t nodes) {
+  QuorumSizes sizes{QuorumSize("paxos.quorum.phase1", nodes),
+                    QuorumSize("paxos.quorum.phase2", nodes)};
+
+  if (sizes.phase1 > nodes || sizes.phase2 > nodes) {
+    WHEELS_PANIC("Quorum size exceeds number of nodes");
+  }
+  if (sizes.phase1 + sizes.phase2 <= nodes) {
+    WHEELS_PANIC("Phase 1 and Phase 2 quorums do not intersect");
+  }
+
+  return sizes;
+}
+
+}  // namespace paxos
@@ -0,0 +1,196 @@
+#include <paxos/client/client.hpp>
+#include <paxos/node/main.hpp>
+
+#include <consensus/value.hpp>
+#include <consensus/checker.hpp>
+
+// Node
+#include <whirl/node/runtime/shortcuts.hpp>
+
+// Logging
+#include <timber/log.hpp>
+
+// Concurrency
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/sync/future.hpp>
+
+// Simulation
+#include <matrix/facade/world.hpp>
+#include <matrix/world/global/vars.hpp>
+#include <matrix/world/global/time.hpp>
+#include <matrix/client/rpc.hpp>
+#include <matrix/test/main.hpp>
+#include <matrix/test/event_log.hpp>
+#include <matrix/test/runner.hpp>
+
+#include <commute/rpc/id.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <tests/common/latency.hpp>
+#include <tests/time_models/paxos.hpp>
+
+using namespace whirl;
+
+//////////////////////////////////////////////////////////////////////
+
+// Decision latency: classic Paxos vs Fast Paxos, fault-free runs
+//
+// Simulation parameters are derived from the seed, so any --sims
+// covers all (mode, clients) combinations evenly
+
+struct BenchConfig {
+  std::string mode;
+  bool fast;
+  size_t clients;
+};
+
+static const std::vector<BenchConfig> kBenchConfigs{
+    {"classic", false, 1}, {"classic", false, 2}, {"classic", false, 4},
+    {"classic", false, 8}, {"fast", true, 1},     {"fast", true, 2},
+    {"fast", true, 4},     {"fast", true, 8},
+};
+
+static const size_t kReplicas = 5;
+
+//////////////////////////////////////////////////////////////////////
+
+// Decision latency per config
+
+std::vector<std::string> BenchLabels() {
+  std::vector<std::string> labels;
+  for (const auto& config : kBenchConfigs) {
+    labels.push_back(config.mode + ", clients = " +
+                     std::to_string(config.clients));
+  }
+  return labels;
+}
+
+static tests::LatencyReport latency_report{BenchLabels()};
+
+// Current simulation
+static size_t bench_config = 0;
+
+//////////////////////////////////////////////////////////////////////
+
+// Safety is checked online, as Propose calls complete
+static consensus::StreamingChecker checker;
+
+//////////////////////////////////////////////////////////////////////
+
+void Client() {
+  await::fibers::self::SetName("main");
+
+  // Clients start almost simultaneously to provoke collisions
+  node::rt::SleepFor(100 + node::rt::RandomNumber(10));
+
+  timber::Logger logger_{"Client", node::rt::LoggerBackend()};
+
+  auto channel = matrix::client::MakeRpcChannel(
+      /*pool_name=*/"paxos", /*port=*/42, /*log_retries=*/false);
+
+  paxos::BlockingClient paxos{channel};
+
+  // Single Propose: later ones are answered from the decision cache
+  consensus::Value value = std::to_string(node::rt::RandomNumber(100));
+  LOG_INFO("Start Propose({})", value);
+  auto start_time = matrix::GlobalNow();
+  checker.Propose(value);
+  auto chosen_value = paxos.Propose(value);
+  LOG_INFO("Chosen value: {}", chosen_value);
+
+  if (!checker.Decide(chosen_value)) {
+    LOG_INFO("Safety violation: {}", checker.Violation());
+  }
+
+  latency_report.Add(bench_config, matrix::GlobalNow() - start_time);
+
+  matrix::GlobalCounter("requests").Increment();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Seed -> simulation digest
+// Deterministic
+size_t RunSimulation(size_t seed) {
+  auto& runner = matrix::TestRunner::Access();
+
+  static const Jiffies kTimeLimit = 100000_jfs;
+
+  bench_config = seed % kBenchConfigs.size();
+  const auto& config = kBenchConfigs[bench_config];
+
+  runner.Verbose() << "Simulation seed: " << seed << ", mode: " << config.mode
+                   << ", clients: " << config.clients << std::endl;
+
+  // Reset RPC ids
+  commute::rpc::ResetIds();
+
+  matrix::facade::World world{seed};
+
+  runner.Configure(world);
+
+  world.SetTimeModel(paxos::MakeTimeModel());
+
+  // Cluster
+  world.MakePool("paxos", paxos::NodeMain).Size(kReplicas);
+
+  // Clients
+  world.AddClients(Client, /*count=*/config.clients);
+
+  // Globals
+  world.InitCounter("requests", 0);
+
+  world.SetGlobal<int64_t>("config.paxos.backoff.init", 100);
+  world.SetGlobal<int64_t>("config.paxos.backoff.max", 2000);
+  world.SetGlobal<int64_t>("config.paxos.backoff.factor", 2);
+
+  world.SetGlobal<int64_t>("config.paxos.quorum.phase1", 0);
+  world.SetGlobal<int64_t>("config.paxos.quorum.phase2", 0);
+
+  // Classic path = both phases
+  world.SetGlobal<int64_t>("config.paxos.optimistic", 0);
+  world.SetGlobal<int64_t>("config.paxos.fast", config.fast ? 1 : 0);
+  world.SetGlobal<int64_t>("config.paxos.fast_timeout", 1000);
+
+  // Run simulation
+
+  checker.Reset();
+
+  world.Start();
+  while (checker.Safe() && world.GetCounter("requests") < config.clients &&
+         world.TimeElapsed() < kTimeLimit) {
+    if (!world.Step()) {
+      break;  // Deadlock
+    }
+  }
+
+  size_t digest = world.Stop();
+
+  if (checker.Safe() && world.GetCounter("requests") < config.clients) {
+    runner.Report() << "Simulation for seed = " << seed
+                    << " did not complete" << std::endl;
+    runner.Fail();
+  }
+
+  // Fast round must not break agreement
+  if (!checker.Safe()) {
+    runner.Report() << "History is NOT SAFE for seed = " << seed << ": "
+                    << checker.Violation() << std::endl;
+    for (const auto& event : checker.Tail()) {
+      runner.Report() << "  " << event << std::endl;
+    }
+    runner.Fail();
+  }
+
+  return digest;
+}
+
+int main(int argc, const char** argv) {
+  int exit_code = matrix::Main(argc, argv, RunSimulation);
+  latency_report.Print(std::cout, "Decision latency, " +
+                                      std::to_string(kReplicas) + " replicas");
+  return exit_code;
+}
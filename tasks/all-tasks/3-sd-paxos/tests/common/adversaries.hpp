@@ -0,0 +1,124 @@
+#pragma once
+
+// Fault injection shared by test binaries
+//
+// Faults stop at the "no_more_faults" global (time point),
+// NodeReaper crashes at most "crash_budget" (global) nodes
+
+// Node
+#include <whirl/node/runtime/shortcuts.hpp>
+
+// Logging
+#include <timber/log.hpp>
+
+// Simulation
+#include <matrix/world/global/vars.hpp>
+#include <matrix/world/global/time.hpp>
+
+#include <matrix/fault/access.hpp>
+#include <matrix/fault/net/split.hpp>
+#include <matrix/fault/util.hpp>
+
+namespace tests {
+
+inline bool FaultsAllowed() {
+  using namespace whirl;
+  return matrix::GlobalNow() < matrix::GetGlobal<size_t>("no_more_faults");
+}
+
+//////////////////////////////////////////////////////////////////////
+
+inline void NetAdversary() {
+  using namespace whirl;
+
+  timber::Logger logger_{"Net-Adversary", node::rt::LoggerBackend()};
+
+  // List system nodes
+  auto pool = node::rt::Discovery()->ListPool("paxos");
+
+  auto& net = matrix::fault::Network();
+
+  while (FaultsAllowed()) {
+    node::rt::SleepFor(node::rt::RandomNumber(10, 1000));
+
+    size_t lhs_size = node::rt::RandomNumber(1, pool.size() - 1);
+    LOG_INFO("Random split: {}/{}", lhs_size, pool.size() - lhs_size);
+    matrix::fault::RandomSplit(pool, lhs_size);
+
+    matrix::fault::RandomPause(100_jfs, 500_jfs);
+
+    net.Heal();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+inline void NodeAdversary() {
+  using namespace whirl;
+
+  timber::Logger logger_{"Node-Adversary", node::rt::LoggerBackend()};
+
+  // List system nodes
+  auto pool = node::rt::Discovery()->ListPool("paxos");
+
+  while (FaultsAllowed()) {
+    // Some random delay
+    matrix::fault::RandomPause(100_jfs, 800_jfs);
+
+    auto& victim = matrix::fault::RandomServer(pool);
+    auto& victim_2 = matrix::fault::RandomServer(pool);
+
+    switch (node::rt::RandomNumber(5)) {
+      case 0:
+      case 1:
+      case 2:
+        // Reboot
+        victim.FastReboot();
+        if (victim.Name() != victim_2.Name()) {
+          victim_2.FastReboot();
+        }
+        break;
+      case 3:
+        // Freeze
+        victim.Pause();
+        matrix::fault::RandomPause(100_jfs, 500_jfs);
+        victim.Resume();
+        break;
+      case 4:
+        // Clocks
+        victim.AdjustWallClock();
+        break;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+inline void NodeReaper() {
+  using namespace whirl;
+
+  timber::Logger logger_{"Node-Reaper", node::rt::LoggerBackend()};
+
+  // List system nodes
+  auto pool = node::rt::Discovery()->ListPool("paxos");
+
+  // Bound on number of crashes
+  size_t bound = matrix::GetGlobal<size_t>("crash_budget");
+
+  // [0, bound]
+  size_t crashes = node::rt::RandomNumber(0, bound);
+
+  LOG_INFO("Crash budget: {}", crashes);
+
+  for (size_t i = 0; i < crashes; ++i) {
+    matrix::fault::RandomPause(100_jfs, 1000_jfs);
+
+    auto& victim = matrix::fault::RandomServer(pool);
+
+    if (victim.IsAlive()) {
+      victim.Crash();
+    }
+  }
+}
+
+}  // namespace tests
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tests {
+
+// Decision latency per simulation config,
+// accumulated over simulations and printed at exit
+
+class LatencyReport {
+  struct Stats {
+    uint64_t total = 0;
+    size_t decisions = 0;
+
+    double Average() const {
+      return decisions > 0 ? (double)total / decisions : 0;
+    }
+  };
+
+ public:
+  // One label per config
+  explicit LatencyReport(std::vector<std::string> configs)
+      : configs_(std::move(configs)), stats_(configs_.size()) {
+  }
+
+  void Add(size_t config, uint64_t latency) {
+    auto& stats = stats_.at(config);
+    stats.total += latency;
+    ++stats.decisions;
+  }
+
+  void Print(std::ostream& out, const std::string& title) const {
+    out << title << ":" << std::endl;
+    for (size_t i = 0; i < configs_.size(); ++i) {
+      out << "  " << configs_[i] << ": " << stats_[i].Average()
+          << " jiffies avg over " << stats_[i].decisions << " decisions"
+          << std::endl;
+    }
+  }
+
+ private:
+  std::vector<std::string> configs_;
+  std::vector<Stats> stats_;
+};
+
+}  // namespace tests
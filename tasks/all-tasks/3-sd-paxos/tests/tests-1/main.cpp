@@ -3,7 +3,6 @@
 
 #include <consensus/value.hpp>
 #include <consensus/checker.hpp>
-#include <consensus/printer.hpp>
 
 // Node
 #include <whirl/node/runtime/shortcuts.hpp>
@@ -30,22 +29,22 @@
 #include <matrix/test/event_log.hpp>
 #include <matrix/test/runner.hpp>
 
-#include <matrix/fault/access.hpp>
-#include <matrix/fault/net/split.hpp>
-#include <matrix/fault/util.hpp>
-
-#include <matrix/semantics/printers/print.hpp>
-
 #include <commute/rpc/id.hpp>
 
 #include <algorithm>
 
-#include "time_model/paxos.hpp"
+#include <tests/common/adversaries.hpp>
+#include <tests/time_models/paxos.hpp>
 
 using namespace whirl;
 
 //////////////////////////////////////////////////////////////////////
 
+// Safety is checked online, as Propose calls complete
+static consensus::StreamingChecker checker;
+
+//////////////////////////////////////////////////////////////////////
+
 [[noreturn]] void Client() {
   await::fibers::self::SetName("main");
 
@@ -64,9 +63,14 @@ using namespace whirl;
   while (true) {
     consensus::Value value = std::to_string(node::rt::RandomNumber(100));
     LOG_INFO("Start Propose({})", value);
+    checker.Propose(value);
     auto chosen_value = paxos.Propose(value);
     LOG_INFO("Chosen value: {}", chosen_value);
 
+    if (!checker.Decide(chosen_value)) {
+      LOG_INFO("Safety violation: {}", checker.Violation());
+    }
+
     matrix::GlobalCounter("requests").Increment();
 
     // Random pause
@@ -80,95 +84,6 @@ static const matrix::TimePoint kNoMoreFaults = 10000;
 
 //////////////////////////////////////////////////////////////////////
 
-void NetAdversary() {
-  timber::Logger logger_{"Net-Adversary", node::rt::LoggerBackend()};
-
-  // List system nodes
-  auto pool = node::rt::Discovery()->ListPool("paxos");
-
-  auto& net = matrix::fault::Network();
-
-  while (matrix::GlobalNow() < kNoMoreFaults) {
-    node::rt::SleepFor(node::rt::RandomNumber(10, 1000));
-
-    size_t lhs_size = node::rt::RandomNumber(1, pool.size() - 1);
-    LOG_INFO("Random split: {}/{}", lhs_size, pool.size() - lhs_size);
-    matrix::fault::RandomSplit(pool, lhs_size);
-
-    matrix::fault::RandomPause(100_jfs, 500_jfs);
-
-    net.Heal();
-  }
-}
-
-//////////////////////////////////////////////////////////////////////
-
-void NodeAdversary() {
-  timber::Logger logger_{"Node-Adversary", node::rt::LoggerBackend()};
-
-  // List system nodes
-  auto pool = node::rt::Discovery()->ListPool("paxos");
-
-  while (matrix::GlobalNow() < kNoMoreFaults) {
-    // Some random delay
-    matrix::fault::RandomPause(100_jfs, 800_jfs);
-
-    auto& victim = matrix::fault::RandomServer(pool);
-    auto& victim_2 = matrix::fault::RandomServer(pool);
-
-    switch (node::rt::RandomNumber(5)) {
-      case 0:
-      case 1:
-      case 2:
-        // Reboot
-        victim.FastReboot();
-        if (victim.Name() != victim_2.Name()) {
-          victim_2.FastReboot();
-        }
-        break;
-      case 3:
-        // Freeze
-        victim.Pause();
-        matrix::fault::RandomPause(100_jfs, 500_jfs);
-        victim.Resume();
-        break;
-      case 4:
-        // Clocks
-        victim.AdjustWallClock();
-        break;
-    }
-  }
-}
-
-//////////////////////////////////////////////////////////////////////
-
-void NodeReaper() {
-  timber::Logger logger_{"Node-Reaper", node::rt::LoggerBackend()};
-
-  // List system nodes
-  auto pool = node::rt::Discovery()->ListPool("paxos");
-
-  // Bound on number of crashes
-  size_t bound = (pool.size() - 1) / 2;
-
-  // [0, bound]
-  size_t crashes = node::rt::RandomNumber(0, bound);
-
-  LOG_INFO("Crash budget: {}", crashes);
-
-  for (size_t i = 0; i < crashes; ++i) {
-    matrix::fault::RandomPause(100_jfs, 1000_jfs);
-
-    auto& victim = matrix::fault::RandomServer(pool);
-
-    if (victim.IsAlive()) {
-      victim.Crash();
-    }
-  }
-}
-
-//////////////////////////////////////////////////////////////////////
-
 // Seed -> simulation digest
 // Deterministic
 size_t RunSimulation(size_t seed) {
@@ -210,33 +125,51 @@ size_t RunSimulation(size_t seed) {
     if (random.Maybe(7)) {
       // Network partitions
       runner.Verbose() << "Partitions" << std::endl;
-      world.AddAdversary(NetAdversary);
+      world.AddAdversary(tests::NetAdversary);
     }
 
     if (random.Maybe(3)) {
       // Reboots, pauses
       runner.Verbose() << "Reboots" << std::endl;
-      world.AddAdversary(NodeAdversary);
+      world.AddAdversary(tests::NodeAdversary);
     }
 
     if (random.Maybe(7)) {
       // Crashes
       runner.Verbose() << "Crashes" << std::endl;
-      world.AddAdversary(NodeReaper);
+      world.AddAdversary(tests::NodeReaper);
     }
   }
 
   // Globals
   world.InitCounter("requests", 0);
 
+  // Adversaries
+  world.SetGlobal<size_t>("no_more_faults", kNoMoreFaults);
+  world.SetGlobal<size_t>("crash_budget", (replicas - 1) / 2);
+
   world.SetGlobal<int64_t>("config.paxos.backoff.init", 100);
   world.SetGlobal<int64_t>("config.paxos.backoff.max", 2000);
   world.SetGlobal<int64_t>("config.paxos.backoff.factor", 2);
 
+  // Distinguished proposer skips Phase 1 in round 0
+  world.SetGlobal<int64_t>("config.paxos.optimistic", 1);
+  // Fast Paxos in every other simulation
+  world.SetGlobal<int64_t>("config.paxos.fast", seed % 2);
+  world.SetGlobal<int64_t>("config.paxos.fast_timeout", 1000);
+
+  // Majority quorums
+  world.SetGlobal<int64_t>("config.paxos.quorum.phase1", 0);
+  world.SetGlobal<int64_t>("config.paxos.quorum.phase2", 0);
+
   // Run simulation
 
+  checker.Reset();
+
   world.Start();
-  while (world.GetCounter("requests") < kRequestsThreshold &&
+  // Stop at the first safety violation
+  while (checker.Safe() &&
+         world.GetCounter("requests") < kRequestsThreshold &&
          world.TimeElapsed() < kTimeLimit) {
     if (!world.Step()) {
       break;  // Deadlock
@@ -251,16 +184,14 @@ size_t RunSimulation(size_t seed) {
                    << "digest: " << digest << ", time: " << world.TimeElapsed()
                    << ", steps: " << world.StepCount() << std::endl;
 
-  const auto event_log = world.EventLog();
-
   runner.Verbose() << "Requests completed: " << world.GetCounter("requests")
                    << std::endl;
 
   // Time limit exceeded
-  if (world.GetCounter("requests") < kRequestsThreshold) {
+  if (checker.Safe() && world.GetCounter("requests") < kRequestsThreshold) {
     // Log
     runner.Report() << "Log:" << std::endl;
-    matrix::WriteTextLog(event_log, runner.Report());
+    matrix::WriteTextLog(world.EventLog(), runner.Report());
     runner.Report() << std::endl;
 
     runner.Report() << "Simulation for seed = " << seed << " failed: ";
@@ -274,19 +205,19 @@ size_t RunSimulation(size_t seed) {
   }
 
   // Check safety properties
-  const auto history = world.History();
-  const bool safe = consensus::IsSafe(history);
 
-  if (!safe) {
+  if (!checker.Safe()) {
     // Log
     runner.Verbose() << "Log:" << std::endl;
-    matrix::WriteTextLog(event_log, runner.Verbose());
+    matrix::WriteTextLog(world.EventLog(), runner.Verbose());
     runner.Verbose() << std::endl;
 
-    // History
-    runner.Report() << "History is NOT SAFE for seed = " << seed << ":"
-                    << std::endl;
-    semantics::Print<consensus::Printer>(history, runner.Report());
+    // Recent calls, the full history is not materialized
+    runner.Report() << "History is NOT SAFE for seed = " << seed << ": "
+                    << checker.Violation() << std::endl;
+    for (const auto& event : checker.Tail()) {
+      runner.Report() << "  " << event << std::endl;
+    }
 
     runner.Fail();
   }
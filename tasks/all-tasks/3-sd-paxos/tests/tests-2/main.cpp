@@ -0,0 +1,286 @@
+#include <paxos/client/client.hpp>
+#include <paxos/node/main.hpp>
+
+#include <consensus/value.hpp>
+#include <consensus/checker.hpp>
+
+// Node
+#include <whirl/node/runtime/shortcuts.hpp>
+
+// Serialization
+#include <muesli/serializable.hpp>
+// Support std::string serialization
+#include <cereal/types/string.hpp>
+
+// Logging
+#include <timber/log.hpp>
+
+// Concurrency
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/sync/future.hpp>
+
+// Simulation
+#include <matrix/facade/world.hpp>
+#include <matrix/world/global/vars.hpp>
+#include <matrix/world/global/time.hpp>
+#include <matrix/client/rpc.hpp>
+#include <matrix/test/random.hpp>
+#include <matrix/test/main.hpp>
+#include <matrix/test/event_log.hpp>
+#include <matrix/test/runner.hpp>
+
+#include <commute/rpc/id.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <tests/common/adversaries.hpp>
+#include <tests/common/latency.hpp>
+#include <tests/time_models/paxos.hpp>
+
+using namespace whirl;
+
+//////////////////////////////////////////////////////////////////////
+
+// Flexible Paxos: Phase 1 / Phase 2 quorum sizes in a five-node pool
+
+struct QuorumConfig {
+  std::string name;
+  int64_t phase1;
+  int64_t phase2;
+};
+
+static const std::vector<QuorumConfig> kQuorumConfigs{
+    {"majority", 3, 3},
+    {"flexible", 4, 2},
+};
+
+static const size_t kReplicas = 5;
+
+//////////////////////////////////////////////////////////////////////
+
+// Decision latency, collected in fault-free simulations only
+
+std::vector<std::string> QuorumLabels() {
+  std::vector<std::string> labels;
+  for (const auto& quorums : kQuorumConfigs) {
+    labels.push_back(quorums.name + " (Q1 = " + std::to_string(quorums.phase1) +
+                     ", Q2 = " + std::to_string(quorums.phase2) + ")");
+  }
+  return labels;
+}
+
+static tests::LatencyReport latency_report{QuorumLabels()};
+
+// Current simulation
+static size_t quorum_config = 0;
+static bool measure_latency = false;
+
+//////////////////////////////////////////////////////////////////////
+
+// Safety is checked online, as Propose calls complete
+static consensus::StreamingChecker checker;
+
+//////////////////////////////////////////////////////////////////////
+
+[[noreturn]] void Client() {
+  await::fibers::self::SetName("main");
+
+  node::rt::SleepFor(123_jfs);
+
+  // + Random delay
+  node::rt::SleepFor({node::rt::RandomNumber(50, 100)});
+
+  timber::Logger logger_{"Client", node::rt::LoggerBackend()};
+
+  auto channel = matrix::client::MakeRpcChannel(
+      /*pool_name=*/"paxos", /*port=*/42, /*log_retries=*/false);
+
+  paxos::BlockingClient paxos{channel};
+
+  for (size_t i = 0;; ++i) {
+    consensus::Value value = std::to_string(node::rt::RandomNumber(100));
+    LOG_INFO("Start Propose({})", value);
+    auto start_time = matrix::GlobalNow();
+    checker.Propose(value);
+    auto chosen_value = paxos.Propose(value);
+    LOG_INFO("Chosen value: {}", chosen_value);
+
+    if (!checker.Decide(chosen_value)) {
+      LOG_INFO("Safety violation: {}", checker.Violation());
+    }
+
+    // Later proposals are answered from the decision cache
+    if (i == 0 && measure_latency) {
+      latency_report.Add(quorum_config, matrix::GlobalNow() - start_time);
+    }
+
+    matrix::GlobalCounter("requests").Increment();
+
+    // Random pause
+    node::rt::SleepFor(node::rt::RandomNumber(1, 100));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+static const matrix::TimePoint kNoMoreFaults = 10000;
+
+//////////////////////////////////////////////////////////////////////
+
+// Seed -> simulation digest
+// Deterministic
+size_t RunSimulation(size_t seed) {
+  auto& runner = matrix::TestRunner::Access();
+
+  static const Jiffies kTimeLimit = 100000_jfs;
+  static const size_t kRequestsThreshold = 4;
+
+  runner.Verbose() << "Simulation seed: " << seed << std::endl;
+
+  matrix::Random random{seed};
+
+  // Randomize simulation parameters
+  const size_t clients = random.Get(1, 3);
+
+  quorum_config = seed % kQuorumConfigs.size();
+  const auto& quorums = kQuorumConfigs[quorum_config];
+
+  runner.Verbose() << "Parameters: "
+                   << "replicas = " << kReplicas << ", "
+                   << "clients = " << clients << ", "
+                   << "quorums = " << quorums.name << " (" << quorums.phase1
+                   << ", " << quorums.phase2 << ")" << std::endl;
+
+  // Reset RPC ids
+  commute::rpc::ResetIds();
+
+  matrix::facade::World world{seed};
+
+  runner.Configure(world);
+
+  world.SetTimeModel(paxos::MakeTimeModel());
+
+  // Cluster
+  world.MakePool("paxos", paxos::NodeMain).Size(kReplicas);
+
+  // Clients
+  world.AddClients(Client, /*count=*/clients);
+
+  // Adversaries
+
+  measure_latency = true;
+
+  if (random.Maybe(3)) {
+    measure_latency = false;
+
+    if (random.Maybe(7)) {
+      // Network partitions
+      runner.Verbose() << "Partitions" << std::endl;
+      world.AddAdversary(tests::NetAdversary);
+    }
+
+    if (random.Maybe(3)) {
+      // Reboots, pauses
+      runner.Verbose() << "Reboots" << std::endl;
+      world.AddAdversary(tests::NodeAdversary);
+    }
+
+    if (random.Maybe(7)) {
+      // Crashes
+      runner.Verbose() << "Crashes" << std::endl;
+      world.AddAdversary(tests::NodeReaper);
+    }
+  }
+
+  // Globals
+  world.InitCounter("requests", 0);
+
+  // Adversaries
+  world.SetGlobal<size_t>("no_more_faults", kNoMoreFaults);
+  // Both quorums should remain available
+  world.SetGlobal<size_t>("crash_budget",
+                          kReplicas - (size_t)std::max(quorums.phase1, quorums.phase2));
+
+  world.SetGlobal<int64_t>("config.paxos.backoff.init", 100);
+  world.SetGlobal<int64_t>("config.paxos.backoff.max", 2000);
+  world.SetGlobal<int64_t>("config.paxos.backoff.factor", 2);
+
+  // Distinguished proposer skips Phase 1 in round 0
+  world.SetGlobal<int64_t>("config.paxos.optimistic", 1);
+  world.SetGlobal<int64_t>("config.paxos.fast", 0);
+  world.SetGlobal<int64_t>("config.paxos.fast_timeout", 1000);
+
+  world.SetGlobal<int64_t>("config.paxos.quorum.phase1", quorums.phase1);
+  world.SetGlobal<int64_t>("config.paxos.quorum.phase2", quorums.phase2);
+
+  // Run simulation
+
+  checker.Reset();
+
+  world.Start();
+  // Stop at the first safety violation
+  while (checker.Safe() &&
+         world.GetCounter("requests") < kRequestsThreshold &&
+         world.TimeElapsed() < kTimeLimit) {
+    if (!world.Step()) {
+      break;  // Deadlock
+    }
+  }
+
+  // Stop and compute simulation digest
+  size_t digest = world.Stop();
+
+  // Print report
+  runner.Verbose() << "Seed " << seed << " -> "
+                   << "digest: " << digest << ", time: " << world.TimeElapsed()
+                   << ", steps: " << world.StepCount() << std::endl;
+
+  runner.Verbose() << "Requests completed: " << world.GetCounter("requests")
+                   << std::endl;
+
+  // Time limit exceeded
+  if (checker.Safe() && world.GetCounter("requests") < kRequestsThreshold) {
+    // Log
+    runner.Report() << "Log:" << std::endl;
+    matrix::WriteTextLog(world.EventLog(), runner.Report());
+    runner.Report() << std::endl;
+
+    runner.Report() << "Simulation for seed = " << seed << " failed: ";
+
+    if (world.TimeElapsed() < kTimeLimit) {
+      runner.Report() << "deadlock in simulation" << std::endl;
+    } else {
+      runner.Report() << "time limit exceeded" << std::endl;
+    }
+    runner.Fail();
+  }
+
+  // Check safety properties
+
+  if (!checker.Safe()) {
+    // Log
+    runner.Verbose() << "Log:" << std::endl;
+    matrix::WriteTextLog(world.EventLog(), runner.Verbose());
+    runner.Verbose() << std::endl;
+
+    // Recent calls, the full history is not materialized
+    runner.Report() << "History is NOT SAFE for seed = " << seed << ": "
+                    << checker.Violation() << std::endl;
+    for (const auto& event : checker.Tail()) {
+      runner.Report() << "  " << event << std::endl;
+    }
+
+    runner.Fail();
+  }
+
+  return digest;
+}
+
+int main(int argc, const char** argv) {
+  int exit_code = matrix::Main(argc, argv, RunSimulation);
+  latency_report.Print(std::cout, "Decision latency (fault-free simulations)");
+  return exit_code;
+}
@@ -1,4 +1,4 @@
-#include "paxos.hpp"
+#include <tests/time_models/paxos.hpp>
 
 #include <matrix/world/global/random.hpp>
 
@@ -11,6 +11,11 @@
 
 #include <wheels/support/panic.hpp>
 
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
 namespace kv {
 
 class StateMachine : public rsm::IStateMachine {
@@ -41,20 +46,42 @@ class StateMachine : public rsm::IStateMachine {
     store_.Install(entries);
   }
 
+  // Commands touch a single key
+  std::optional<std::vector<std::string>> Footprint(
+      const rsm::Command& cmd) override {
+    if (cmd.type == "Set") {
+      return Footprint<Set>(cmd);
+    } else if (cmd.type == "Get") {
+      return Footprint<Get>(cmd);
+    } else if (cmd.type == "Cas") {
+      return Footprint<Cas>(cmd);
+    }
+    return std::nullopt;
+  }
+
  private:
   Set::Response ApplyImpl(Set::Request set) {
+    std::lock_guard guard(mutex_);
     store_.Set(set.key, set.value);
     return {};
   }
 
   Get::Response ApplyImpl(Get::Request get) {
+    std::lock_guard guard(mutex_);
     return {store_.Get(get.key)};
   }
 
   Cas::Response ApplyImpl(Cas::Request cas) {
+    std::lock_guard guard(mutex_);
     return {store_.Cas(cas.key, cas.expected_value, cas.target_value)};
   }
 
+  template <typename Op>
+  std::vector<std::string> Footprint(const rsm::Command& cmd) {
+    auto request = muesli::Deserialize<typename Op::Request>(cmd.request);
+    return {request.key};
+  }
+
   template <typename Op>
   muesli::Bytes Apply(const rsm::Command& cmd) {
     auto request = muesli::Deserialize<typename Op::Request>(cmd.request);
@@ -63,6 +90,9 @@ class StateMachine : public rsm::IStateMachine {
   }
 
  private:
+  // Commands with disjoint footprints are applied concurrently,
+  // (de)serialization runs outside of the lock
+  std::mutex mutex_;
   Store store_;
 };
 
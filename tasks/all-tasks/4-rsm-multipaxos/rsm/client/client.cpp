@@ -21,10 +21,34 @@ Client::Client(commute::rpc::IChannelPtr proxies)
 
 muesli::Bytes Client::Execute(std::string type, muesli::Bytes request,
                               bool readonly) {
+  if (!session_open_) {
+    OpenSession();
+  }
+
   auto request_id = NextRequestId();
 
-  Command cmd{std::move(type), std::move(request), request_id, readonly};
+  Command cmd{std::move(type), std::move(request), request_id, readonly,
+              acked_index_};
+
+  auto response = Send(cmd);
+  // Replicas drop cached response
+  acked_index_ = request_id.index;
+  return response;
+}
+
+void Client::GenerateClientId() {
+  client_id_ = node::rt::GenerateGuid();
+}
+
+void Client::OpenSession() {
+  Command cmd{/*type=*/"", /*request=*/{}, /*request_id=*/{client_id_, 0},
+              /*readonly=*/false, /*acked=*/0};
+
+  client_id_ = muesli::Deserialize<std::string>(Send(cmd));
+  session_open_ = true;
+}
 
+muesli::Bytes Client::Send(const Command& cmd) {
   auto f = commute::rpc::Call("RSM.Execute")
                .Args(cmd)
                .Via(proxies_)
@@ -36,10 +60,6 @@ muesli::Bytes Client::Execute(std::string type, muesli::Bytes request,
   return await::fibers::Await(std::move(f)).ValueOrThrow();
 }
 
-void Client::GenerateClientId() {
-  client_id_ = node::rt::GenerateGuid();
-}
-
 commute::rpc::TraceId Client::MakeTraceId(const Command& cmd) {
   return fmt::format("{}", cmd.request_id);
 }
@@ -18,19 +18,27 @@ class Client {
  public:
   explicit Client(commute::rpc::IChannelPtr proxies);
 
+  // Throws if the client session has expired (see rsm::SessionTable)
   muesli::Bytes Execute(std::string type, muesli::Bytes request, bool readonly);
 
  private:
   void GenerateClientId();
+  // Session id assigned by replicas becomes the client id
+  void OpenSession();
   RequestId NextRequestId();
 
+  muesli::Bytes Send(const Command& cmd);
+
   commute::rpc::TraceId MakeTraceId(const Command& cmd);
 
  private:
   commute::rpc::IChannelPtr proxies_;
 
   std::string client_id_;
+  bool session_open_{false};
   uint64_t request_index_{0};
+  // Last request with received response
+  uint64_t acked_index_{0};
 };
 
 }  // namespace rsm
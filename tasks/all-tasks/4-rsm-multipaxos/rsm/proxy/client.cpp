@@ -9,12 +9,15 @@
 #include <commute/rpc/client.hpp>
 #include <commute/rpc/errors.hpp>
 
+#include <stdexcept>
+
 using namespace whirl;
 
 namespace rsm {
 
 ProxyClient::ProxyClient(const std::string& rsm_pool_name)
-    : logger_("RSM-Proxy-Client", node::rt::LoggerBackend()) {
+    : any_replica_(node::rt::Config()->GetString("rsm.mode") != "leader"),
+      logger_("RSM-Proxy-Client", node::rt::LoggerBackend()) {
   ConnectToRSM(rsm_pool_name);
 }
 
@@ -72,6 +75,13 @@ muesli::Bytes ProxyClient::Execute(const Command& command) {
       ForgetLeader();
       node::rt::SleepFor(50_jfs);
       continue;
+    } else if (rsm_response.index() == 3) {
+      // Session expired, the command may have been applied:
+      // retrying it would break exactly-once
+      SessionExpired expired = std::get<3>(rsm_response);
+      LOG_INFO("Session of client {} expired", expired.client_id);
+      throw std::runtime_error("Session of client " + expired.client_id +
+                               " expired");
     }
   }
 }
@@ -91,6 +101,10 @@ std::string ProxyClient::PickRandomReplica() {
 }
 
 std::string ProxyClient::ChooseReplica(const Command& /*cmd*/) {
+  if (any_replica_) {
+    return PickRandomReplica();
+  }
+
   auto lock = mutex_.Guard();
   if (leader_.has_value()) {
     return *leader_;
@@ -38,6 +38,10 @@ class ProxyClient {
   std::vector<std::string> replicas_;
   std::map<std::string, commute::rpc::IChannelPtr> channels_;
 
+  // rsm.mode = mencius: any replica accepts commands,
+  // spread them instead of hunting for the leader
+  const bool any_replica_;
+
   await::fibers::Mutex mutex_;  // Guards leader_
   std::optional<std::string> leader_;
 
@@ -0,0 +1,90 @@
+#include <rsm/replica/apply.hpp>
+
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/sync/future.hpp>
+
+#include <memory>
+
+namespace rsm {
+
+Applier::Applier(IStateMachinePtr state_machine, size_t parallelism)
+    : state_machine_(std::move(state_machine)),
+      parallelism_(parallelism) {
+}
+
+std::vector<muesli::Bytes> Applier::Apply(
+    const std::vector<Command>& commands) {
+  std::vector<muesli::Bytes> responses(commands.size());
+
+  if (parallelism_ <= 1) {
+    ApplyWave(commands, 0, commands.size(), responses);
+    return responses;
+  }
+
+  // Current wave
+  size_t begin = 0;
+  std::set<std::string> keys;
+
+  for (size_t i = 0; i < commands.size(); ++i) {
+    auto footprint = state_machine_->Footprint(commands[i]);
+
+    if (!footprint.has_value()) {
+      // Conflicts with everything: apply alone
+      ApplyWave(commands, begin, i, responses);
+      ApplyWave(commands, i, i + 1, responses);
+      begin = i + 1;
+      keys.clear();
+      continue;
+    }
+
+    bool conflict = i - begin >= parallelism_;
+    for (const auto& key : *footprint) {
+      conflict = conflict || keys.count(key) > 0;
+    }
+
+    if (conflict) {
+      ApplyWave(commands, begin, i, responses);
+      begin = i;
+      keys.clear();
+    }
+
+    keys.insert(footprint->begin(), footprint->end());
+  }
+
+  ApplyWave(commands, begin, commands.size(), responses);
+
+  return responses;
+}
+
+void Applier::ApplyWave(const std::vector<Command>& commands, size_t begin,
+                        size_t end, std::vector<muesli::Bytes>& responses) {
+  if (parallelism_ <= 1 || end - begin <= 1) {
+    for (size_t i = begin; i < end; ++i) {
+      responses[i] = state_machine_->Apply(commands[i]);
+    }
+    return;
+  }
+
+  std::vector<await::futures::Future<muesli::Bytes>> futures;
+
+  for (size_t i = begin; i < end; ++i) {
+    auto [future, promise] = await::futures::MakeContract<muesli::Bytes>();
+    auto response = std::make_shared<await::futures::Promise<muesli::Bytes>>(
+        std::move(promise));
+
+    const auto* command = &commands[i];
+
+    await::fibers::Go([this, command, response]() {
+      std::move(*response).SetValue(state_machine_->Apply(*command));
+    });
+
+    futures.push_back(std::move(future));
+  }
+
+  for (size_t i = begin; i < end; ++i) {
+    responses[i] =
+        await::fibers::Await(std::move(futures[i - begin])).ValueOrThrow();
+  }
+}
+
+}  // namespace rsm
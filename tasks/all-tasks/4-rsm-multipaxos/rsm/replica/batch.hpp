@@ -0,0 +1,61 @@
+#pragma once
+
+#include <rsm/client/command.hpp>
+
+#include <muesli/serializable.hpp>
+
+#include <cereal/types/vector.hpp>
+
+#include <ostream>
+#include <vector>
+
+namespace rsm {
+
+// Commands decided together in a single log slot,
+// applied in order
+//
+// Empty batch = no-op, fills slots abandoned by proposers
+
+struct Batch {
+  std::vector<Command> commands;
+
+  bool IsNop() const {
+    return commands.empty();
+  }
+
+  // Total size of serialized requests
+  size_t Bytes() const {
+    size_t bytes = 0;
+    for (const auto& command : commands) {
+      bytes += command.request.size();
+    }
+    return bytes;
+  }
+
+  MUESLI_SERIALIZABLE(commands)
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline bool operator==(const Batch& lhs, const Batch& rhs) {
+  return lhs.commands == rhs.commands;
+}
+
+inline bool operator!=(const Batch& lhs, const Batch& rhs) {
+  return !(lhs == rhs);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+inline std::ostream& operator<<(std::ostream& out, const Batch& batch) {
+  if (batch.IsNop()) {
+    return out << "nop";
+  }
+  out << "[" << batch.commands.front();
+  if (batch.commands.size() > 1) {
+    out << " + " << batch.commands.size() - 1 << " more";
+  }
+  return out << "]";
+}
+
+}  // namespace rsm
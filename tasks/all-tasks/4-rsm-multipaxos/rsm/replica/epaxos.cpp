@@ -0,0 +1,748 @@
+#include <rsm/replica/epaxos.hpp>
+
+#include <rsm/replica/apply.hpp>
+#include <rsm/replica/epaxos/acceptor.hpp>
+#include <rsm/replica/epaxos/graph.hpp>
+#include <rsm/replica/epaxos/proto.hpp>
+#include <rsm/replica/epaxos/quorum.hpp>
+#include <rsm/replica/paxos/quorum.hpp>
+#include <rsm/replica/session.hpp>
+
+#include <muesli/serialize.hpp>
+
+#include <commute/rpc/call.hpp>
+
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/sync/channel.hpp>
+#include <await/fibers/sync/mutex.hpp>
+
+#include <timber/log.hpp>
+
+#include <whirl/node/runtime/shortcuts.hpp>
+#include <whirl/node/cluster/peer.hpp>
+#include <whirl/node/store/kv.hpp>
+
+#include <wheels/support/panic.hpp>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+using await::futures::Future;
+using await::futures::Promise;
+
+using namespace whirl;
+
+namespace rsm {
+
+//////////////////////////////////////////////////////////////////////
+
+// Leaderless replication in the spirit of EPaxos
+//
+// Every replica is the command leader for batches in its own slots
+// (Mencius numbering). Batch commits in a single round trip if a fast
+// quorum of acceptors knows no interfering batch beyond the owner,
+// otherwise in two with dependencies merged over a majority.
+// Interference is decided by key footprints of commands.
+// Committed batches are ordered by the dependency graph, see
+// epaxos::ExecutionGraph
+//
+// Instance that blocks execution for epaxos.recover.timeout is finished
+// by a recovery round (explicit Prepare): committed value, the highest
+// vote or a no-op
+
+class EPaxos : public IReplica, public node::cluster::Peer {
+  struct PendingCommand {
+    Command command;
+    Promise<Response> promise;
+  };
+
+ public:
+  explicit EPaxos(IStateMachinePtr state_machine)
+      : Peer(node::rt::Config()),
+        state_machine_(std::move(state_machine)),
+        applier_(state_machine_,
+                 node::rt::Config()->GetInt<size_t>("rsm.apply.parallelism")),
+        sessions_(/*capacity=*/0),
+        fast_timeout_(
+            node::rt::Config()->GetInt<uint64_t>("epaxos.fast.timeout")),
+        recover_timeout_(
+            node::rt::Config()->GetInt<uint64_t>("epaxos.recover.timeout")),
+        round_store_(node::rt::Database(), "epaxos.proposer"),
+        commands_(kQueueCapacity),
+        window_(node::rt::Config()->GetInt<size_t>("paxos.window")),
+        batch_size_(node::rt::Config()->GetInt<size_t>("paxos.batch.size")),
+        batch_delay_(
+            node::rt::Config()->GetInt<uint64_t>("paxos.batch.delay")),
+        decisions_(kCommittedWindow),
+        logger_("Replica", node::rt::LoggerBackend()) {
+    // Fail fast instead of silently ignoring the bound, see sessions_
+    if (node::rt::Config()->GetInt<size_t>("rsm.sessions.max") != 0) {
+      WHEELS_PANIC("rsm.sessions.max is not supported in epaxos mode, "
+                   "set it to 0");
+    }
+  }
+
+  Future<Response> Execute(Command command) override {
+    auto [future, promise] = await::futures::MakeContract<Response>();
+
+    LOG_INFO("Executing command {}", command);
+
+    // Any replica leads commands
+    commands_.Send({std::move(command), std::move(promise)});
+
+    return std::move(future);
+  };
+
+  void Start(commute::rpc::IServer* server) {
+    // Reset state machine state
+    state_machine_->Reset();
+
+    // Slot owners
+    replicas_ = ListPeers().WithMe();
+    std::sort(replicas_.begin(), replicas_.end());
+
+    graph_.emplace(replicas_.size());
+
+    acceptor_ = std::make_shared<epaxos::Acceptor>(
+        replicas_.size(),
+        [this](const Batch& batch) {
+          return BatchFootprint(batch);
+        },
+        [this](epaxos::InstanceId slot, epaxos::Attributes attrs) {
+          Learn(slot, std::move(attrs));
+        });
+
+    max_round_ = round_store_.GetOr(kRoundKey, 0);
+
+    // Executes replayed instances
+    await::fibers::Go([this]() {
+      ExecuteCommitted();
+    });
+
+    // Replay committed instances, there are no snapshots in this mode:
+    // state machine is rebuilt from scratch
+    acceptor_->Recover();
+
+    SkipUnused();
+
+    // Launch pipeline fibers
+    await::fibers::Go([this]() {
+      AssignSlots();
+    });
+    await::fibers::Go([this]() {
+      RunRecovery();
+    });
+
+    // Register RPC services
+    server->RegisterService("EPaxos", acceptor_);
+  }
+
+ private:
+  const std::string& Owner(epaxos::InstanceId slot) const {
+    return replicas_[epaxos::OwnerIndex(slot, replicas_.size())];
+  }
+
+  // First slot >= from owned by this replica
+  epaxos::InstanceId NextOwnSlot(epaxos::InstanceId from) const {
+    auto slot = std::max<epaxos::InstanceId>(from, 1);
+    while (Owner(slot) != node::rt::HostName()) {
+      ++slot;
+    }
+    return slot;
+  }
+
+  // Own slots below the durable horizon that were not proposed before
+  // restart: only a no-op can be committed there, commit it right away
+  // so that peers do not wait for recovery
+  void SkipUnused() {
+    auto horizon = acceptor_->Horizon();
+
+    epaxos::proto::Commit::Request skip;
+
+    for (auto slot = NextOwnSlot(1); slot < horizon;
+         slot += replicas_.size()) {
+      if (acceptor_->Unused(slot)) {
+        acceptor_->MarkCommitted(slot, epaxos::Attributes::Nop());
+        skip.decisions.push_back({slot, epaxos::Attributes::Nop()});
+      }
+    }
+
+    {
+      auto guard = mutex_.Guard();
+      next_slot_ = NextOwnSlot(horizon);
+    }
+
+    if (!skip.decisions.empty()) {
+      LOG_INFO("Skip {} unused own slots below {}", skip.decisions.size(),
+               horizon);
+      BroadcastCommit(std::move(skip));
+    }
+  }
+
+  // Interference
+
+  // Keys of all commands in the batch. Commands of the same client
+  // interfere via a per-client key: session table state depends on the
+  // order of client requests, starting with the session-opening one
+  epaxos::Footprint BatchFootprint(const Batch& batch) {
+    std::vector<std::string> keys;
+
+    for (const auto& command : batch.commands) {
+      const auto& client_id = command.request_id.client_id;
+      keys.push_back(kClientKeyPrefix + SessionTable::ClientOf(client_id));
+
+      if (command.OpensSession()) {
+        continue;  // Not applied to the state machine
+      }
+
+      auto footprint = state_machine_->Footprint(command);
+      if (!footprint.has_value()) {
+        return std::nullopt;
+      }
+      keys.insert(keys.end(), footprint->begin(), footprint->end());
+    }
+
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+  }
+
+  // Pipeline
+
+  // 1) Assign batches of commands to own slots in arrival order,
+  // keeping at most paxos.window instances in flight
+  void AssignSlots() {
+    while (true) {
+      std::vector<PendingCommand> batch;
+      batch.push_back(commands_.Receive());
+
+      // Acquire window slot, released when the instance completes
+      window_.Send(true);
+
+      CollectBatch(batch);
+
+      auto guard = mutex_.Guard();
+
+      auto slot = next_slot_;
+      next_slot_ += replicas_.size();
+
+      Batch proposal;
+
+      auto& waiters = waiters_[slot];
+      for (auto& command : batch) {
+        waiters.push_back(
+            {command.command.request_id, std::move(command.promise)});
+        proposal.commands.push_back(std::move(command.command));
+      }
+
+      LOG_INFO("Propose batch of {} commands in slot {}", batch.size(), slot);
+
+      // 2) Commit: instances of the owner are independent
+      await::fibers::Go([this, slot, proposal = std::move(proposal)]() {
+        Replicate(slot, proposal);
+        window_.Receive();
+      });
+    }
+  }
+
+  // Up to paxos.batch.size commands, waits at most paxos.batch.delay
+  // for more to arrive
+  void CollectBatch(std::vector<PendingCommand>& batch) {
+    DrainCommands(batch);
+
+    if (batch.size() < batch_size_ && batch_delay_.Count() > 0) {
+      node::rt::SleepFor(batch_delay_);
+      DrainCommands(batch);
+    }
+  }
+
+  void DrainCommands(std::vector<PendingCommand>& batch) {
+    while (batch.size() < batch_size_) {
+      auto command = commands_.TryReceive();
+      if (!command.has_value()) {
+        break;
+      }
+      batch.push_back(std::move(*command));
+    }
+  }
+
+  // Command leader: fast round, slow round if acceptors know
+  // interfering batches the owner does not
+  void Replicate(epaxos::InstanceId slot, const Batch& batch) {
+    const auto fast = epaxos::FastRound(node::rt::HostName());
+
+    epaxos::Attributes attrs{batch, acceptor_->Lead(slot, fast, batch)};
+
+    auto outcome = RunPreAccept(slot, fast, attrs);
+
+    using Path = epaxos::PreAcceptOutcome::Path;
+
+    if (outcome.path == Path::Fast) {
+      if (acceptor_->CommitFast(slot)) {
+        LOG_INFO("Fast commit in slot {}", slot);
+        BroadcastCommit({{{slot, attrs}}});
+        return;
+      }
+    } else if (outcome.path == Path::Slow) {
+      LOG_INFO("Conflicts in slot {}, take slow path", slot);
+
+      // Ordered after every interfering batch known to a majority
+      epaxos::Merge(attrs.deps, outcome.deps);
+
+      epaxos::Vote proposal{epaxos::SlowRound(node::rt::HostName()), attrs};
+
+      auto accepted = RunAccept(slot, proposal);
+
+      if (accepted.ok) {
+        acceptor_->MarkCommitted(slot, attrs);
+        BroadcastCommit({{{slot, attrs}}});
+        return;
+      }
+
+      AdoptAdvice(accepted.advice);
+    }
+
+    // Instance is finished by recovery, commands may be committed
+    // anyway, clients retry
+    LOG_INFO("Give up slot {}", slot);
+
+    auto guard = mutex_.Guard();
+    FailWaiters(slot);
+  }
+
+  epaxos::PreAcceptOutcome RunPreAccept(epaxos::InstanceId slot,
+                                        const epaxos::ProposalNumber& n,
+                                        const epaxos::Attributes& attrs) {
+    std::vector<Future<epaxos::proto::PreAccept::Response>> responses;
+
+    for (const auto& peer : ListPeers().WithoutMe()) {
+      responses.push_back(  //
+          commute::rpc::Call("EPaxos.PreAccept")
+              .Args(epaxos::proto::PreAccept::Request{slot, n, attrs.batch,
+                                                      attrs.deps})
+              .Via(Channel(peer))
+              .Context(await::context::ThisFiber())
+              .AtLeastOnce()
+              .Start()
+              .As<epaxos::proto::PreAccept::Response>());
+    }
+
+    // Owner votes too
+    const size_t nodes = NodeCount();
+
+    return await::fibers::Await(
+               epaxos::PreAcceptQuorum(std::move(responses),
+                                       epaxos::FastQuorum(nodes) - 1,
+                                       paxos::Majority(nodes) - 1,
+                                       fast_timeout_))
+        .ValueOrThrow();
+  }
+
+  paxos::QuorumOutcome<epaxos::proto::Prepare> RunPrepare(
+      epaxos::InstanceId slot, const epaxos::ProposalNumber& n) {
+    std::vector<Future<epaxos::proto::Prepare::Response>> promises;
+
+    for (const auto& peer : ListPeers().WithMe()) {
+      promises.push_back(  //
+          commute::rpc::Call("EPaxos.Prepare")
+              .Args(epaxos::proto::Prepare::Request{slot, n})
+              .Via(Channel(peer))
+              .Context(await::context::ThisFiber())
+              .AtLeastOnce()
+              .Start()
+              .As<epaxos::proto::Prepare::Response>());
+    }
+
+    return await::fibers::Await(paxos::PhaseQuorum<epaxos::proto::Prepare>(
+                                    std::move(promises),
+                                    paxos::Majority(NodeCount())))
+        .ValueOrThrow();
+  }
+
+  paxos::QuorumOutcome<epaxos::proto::Accept> RunAccept(
+      epaxos::InstanceId slot, const epaxos::Vote& proposal) {
+    std::vector<Future<epaxos::proto::Accept::Response>> votes;
+
+    for (const auto& peer : ListPeers().WithMe()) {
+      votes.push_back(  //
+          commute::rpc::Call("EPaxos.Accept")
+              .Args(epaxos::proto::Accept::Request{slot, proposal})
+              .Via(Channel(peer))
+              .Context(await::context::ThisFiber())
+              .AtLeastOnce()
+              .Start()
+              .As<epaxos::proto::Accept::Response>());
+    }
+
+    return await::fibers::Await(paxos::PhaseQuorum<epaxos::proto::Accept>(
+                                    std::move(votes),
+                                    paxos::Majority(NodeCount())))
+        .ValueOrThrow();
+  }
+
+  // Without mutex
+  void BroadcastCommit(epaxos::proto::Commit::Request commit) {
+    for (const auto& peer : ListPeers().WithoutMe()) {
+      await::fibers::Go([this, peer, commit]() {
+        // Lost commit stalls peer until it recovers the instance
+        auto ack = await::fibers::Await(
+            commute::rpc::Call("EPaxos.Commit")
+                .Args(commit)
+                .Via(Channel(peer))
+                .Context(await::context::ThisFiber())
+                .AtMostOnce()
+                .Start()
+                .As<epaxos::proto::Commit::Response>());
+        if (!ack.IsOk()) {
+          LOG_INFO("Failed to deliver commit to {}", peer);
+        }
+      });
+    }
+  }
+
+  // With mutex
+  void FailWaiters(epaxos::InstanceId slot) {
+    if (auto it = waiters_.find(slot); it != waiters_.end()) {
+      for (auto& waiter : it->second) {
+        std::move(waiter.promise).SetValue(NotALeader{});
+      }
+      waiters_.erase(it);
+    }
+  }
+
+  // Recovery
+
+  // Slots blocking execution for a whole period are recovered,
+  // jitter separates replicas recovering the same slot
+  void RunRecovery() {
+    std::set<epaxos::InstanceId> stalled;
+
+    while (true) {
+      node::rt::SleepFor(node::rt::RandomNumber(recover_timeout_.Count(),
+                                                2 * recover_timeout_.Count()));
+
+      std::vector<epaxos::InstanceId> slots;
+
+      {
+        auto guard = mutex_.Guard();
+
+        for (auto slot : missing_) {
+          if (slots.size() == kRecoverLimit) {
+            break;
+          }
+          // Own instance in flight
+          if (Owner(slot) == node::rt::HostName() && waiters_.count(slot) > 0) {
+            continue;
+          }
+          if (stalled.count(slot) > 0) {
+            slots.push_back(slot);
+          }
+        }
+
+        stalled = missing_;
+      }
+
+      if (!slots.empty()) {
+        RecoverAll(slots);
+      }
+    }
+  }
+
+  void RecoverAll(const std::vector<epaxos::InstanceId>& slots) {
+    LOG_INFO("Recover {} slots starting from {}", slots.size(), slots.front());
+
+    std::vector<Future<bool>> recovered;
+
+    for (auto slot : slots) {
+      auto [future, promise] = await::futures::MakeContract<bool>();
+      auto done = std::make_shared<Promise<bool>>(std::move(promise));
+
+      await::fibers::Go([this, slot, done]() {
+        std::move(*done).SetValue(Recover(slot));
+      });
+
+      recovered.push_back(std::move(future));
+    }
+
+    for (auto& future : recovered) {
+      await::fibers::Await(std::move(future)).ValueOrThrow();
+    }
+  }
+
+  // Single recovery round
+  bool Recover(epaxos::InstanceId slot) {
+    auto n = NextRecoveryRound();
+
+    // Phase 1
+
+    auto promises = RunPrepare(slot, n);
+
+    if (!promises.ok) {
+      AdoptAdvice(promises.advice);
+      return false;
+    }
+
+    bool committed = false;
+    auto attrs = RecoveredValue(slot, promises.acks, committed);
+
+    // Phase 2
+
+    if (!committed) {
+      auto accepted = RunAccept(slot, {n, attrs});
+      if (!accepted.ok) {
+        AdoptAdvice(accepted.advice);
+        return false;
+      }
+    }
+
+    LOG_INFO("Recovered slot {}: {}", slot, attrs);
+
+    acceptor_->MarkCommitted(slot, attrs);
+    BroadcastCommit({{{slot, attrs}}});
+    return true;
+  }
+
+  // 1) Committed value
+  // 2) Vote of the highest slow / recovery round
+  // 3) Fast round attributes if they may have been committed: owner
+  // did not respond and Majority - 1 peers voted for them
+  // (see epaxos::FastQuorum). Owner that responded promised
+  // the recovery round and will not commit the fast round
+  // 4) No-op
+  epaxos::Attributes RecoveredValue(
+      epaxos::InstanceId slot,
+      const std::vector<epaxos::proto::Prepare::Response>& promises,
+      bool& committed) {
+    const auto& owner = Owner(slot);
+
+    std::optional<epaxos::Vote> highest;
+    std::optional<epaxos::Attributes> fast;
+    size_t fast_votes = 0;
+    bool owner_responded = false;
+
+    for (const auto& promise : promises) {
+      if (promise.committed) {
+        committed = true;
+        return promise.vote->attrs;
+      }
+      if (promise.node == owner) {
+        owner_responded = true;
+      }
+      if (!promise.vote.has_value()) {
+        continue;
+      }
+      if (promise.vote->n.round > 0) {
+        if (!highest.has_value() || highest->n < promise.vote->n) {
+          highest = promise.vote;
+        }
+      } else if (promise.node != owner) {
+        fast = promise.vote->attrs;
+        ++fast_votes;
+      }
+    }
+
+    if (highest.has_value()) {
+      return highest->attrs;
+    }
+
+    if (fast.has_value() && !owner_responded &&
+        fast_votes + 1 >= paxos::Majority(NodeCount())) {
+      return *fast;
+    }
+
+    return epaxos::Attributes::Nop();
+  }
+
+  // Recovery round numbers, persistent: never reused after restart
+
+  epaxos::ProposalNumber NextRecoveryRound() {
+    auto guard = mutex_.Guard();
+    max_round_ = std::max(max_round_ + 1, epaxos::kFirstRecoveryRound);
+    round_store_.Put(kRoundKey, max_round_);
+    return {max_round_, node::rt::HostName()};
+  }
+
+  void AdoptAdvice(const epaxos::ProposalNumber& advice) {
+    auto guard = mutex_.Guard();
+    max_round_ = std::max(max_round_, advice.round);
+  }
+
+  // Execution
+
+  // Without mutex
+  void Learn(epaxos::InstanceId slot, epaxos::Attributes attrs) {
+    decisions_.Send({slot, std::move(attrs)});
+  }
+
+  // 3) Execute: committed instances arrive in any order, executed
+  // once their dependencies are
+  void ExecuteCommitted() {
+    while (true) {
+      auto decision = decisions_.Receive();
+
+      auto footprint = BatchFootprint(decision.attrs.batch);
+
+      auto guard = mutex_.Guard();
+
+      graph_->Commit(decision.slot, std::move(decision.attrs),
+                     std::move(footprint));
+
+      ExecuteReady();
+    }
+  }
+
+  // With mutex
+  void ExecuteReady() {
+    std::set<epaxos::InstanceId> missing;
+
+    auto ready = graph_->Drain(
+        [this](epaxos::InstanceId slot) {
+          return acceptor_->Recorded(slot);
+        },
+        missing);
+
+    missing_ = std::move(missing);
+
+    for (auto& [slot, batch] : ready) {
+      ApplyBatch(slot, batch);
+    }
+  }
+
+  // With mutex
+  void ApplyBatch(epaxos::InstanceId slot, const Batch& batch) {
+    std::map<RequestId, Response> responses;
+
+    // Exactly-once: retries are answered from the session table
+    std::vector<Command> fresh;
+    for (size_t i = 0; i < batch.commands.size(); ++i) {
+      const auto& command = batch.commands[i];
+      if (responses.count(command.request_id) > 0) {
+        continue;  // Retry within the batch
+      }
+      if (command.OpensSession()) {
+        // Position in the log makes the session id unique
+        auto client_id = SessionTable::MakeSessionId(command, slot, i);
+        sessions_.Open(client_id);
+        responses.emplace(command.request_id,
+                          Ack{muesli::Serialize(client_id)});
+        continue;
+      }
+      const auto& client_id = command.request_id.client_id;
+      if (!sessions_.Has(client_id)) {
+        // Evicted: the command may have been applied already
+        responses.emplace(command.request_id, SessionExpired{client_id});
+        continue;
+      }
+      sessions_.Acknowledge(command);
+      if (auto response = sessions_.Lookup(command.request_id)) {
+        responses.emplace(command.request_id, Ack{std::move(*response)});
+      } else {
+        // Placeholder, filled in once applied
+        responses.emplace(command.request_id, Ack{});
+        fresh.push_back(command);
+      }
+    }
+
+    auto results = applier_.Apply(fresh);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+      const auto& command = fresh[i];
+      sessions_.Record(command.request_id, results[i]);
+      responses.insert_or_assign(command.request_id,
+                                 Ack{std::move(results[i])});
+    }
+
+    if (auto it = waiters_.find(slot); it != waiters_.end()) {
+      for (auto& waiter : it->second) {
+        if (auto response = responses.find(waiter.request_id);
+            response != responses.end()) {
+          std::move(waiter.promise).SetValue(response->second);
+        } else {
+          // Recovered with a no-op
+          std::move(waiter.promise).SetValue(NotALeader{});
+        }
+      }
+      waiters_.erase(it);
+    }
+  }
+
+ private:
+  // Committed, not yet executed instances in the channel
+  static const size_t kCommittedWindow = 1024;
+  static const size_t kQueueCapacity = 1024;
+  // Slots per recovery round
+  static const size_t kRecoverLimit = 64;
+
+  static inline const std::string kRoundKey = "round";
+  // Not a valid client id prefix, user keys may collide with it only
+  // at the cost of extra dependencies
+  static inline const std::string kClientKeyPrefix = "#client:";
+
+  using Decision = epaxos::proto::Commit::Decision;
+
+  struct Waiter {
+    RequestId request_id;
+    Promise<Response> promise;
+  };
+
+  // Replicated state
+  IStateMachinePtr state_machine_;
+  // rsm.apply.parallelism
+  Applier applier_;
+  // Unbounded, rsm.sessions.max must be 0: LRU eviction would depend on
+  // the execution order of non-interfering commands, replicas would
+  // expire different sessions and diverge. Acknowledged responses are
+  // still dropped (Command::acked), an idle session keeps only its id
+  // and last index
+  SessionTable sessions_;
+
+  // Sorted, slot owners
+  std::vector<std::string> replicas_;
+
+  std::shared_ptr<epaxos::Acceptor> acceptor_;
+
+  // epaxos.fast.timeout
+  const Jiffies fast_timeout_;
+  // epaxos.recover.timeout
+  const Jiffies recover_timeout_;
+
+  node::store::KVStore<uint64_t> round_store_;
+
+  // Pipeline stages
+  await::fibers::Channel<PendingCommand> commands_;
+  // Semaphore, capacity = paxos.window
+  await::fibers::Channel<bool> window_;
+  // paxos.batch.{size, delay}
+  const size_t batch_size_;
+  const Jiffies batch_delay_;
+  await::fibers::Channel<Decision> decisions_;
+
+  await::fibers::Mutex mutex_;
+  // Next own slot
+  epaxos::InstanceId next_slot_ = 1;
+  // Max recovery round used or observed
+  uint64_t max_round_ = 0;
+  std::optional<epaxos::ExecutionGraph> graph_;
+  // Uncommitted slots blocking execution
+  std::set<epaxos::InstanceId> missing_;
+  // Slot -> pending Execute calls
+  std::map<epaxos::InstanceId, std::vector<Waiter>> waiters_;
+
+  // Logging
+  timber::Logger logger_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+IReplicaPtr MakeEPaxosReplica(IStateMachinePtr state_machine,
+                              commute::rpc::IServer* server) {
+  auto replica = std::make_shared<EPaxos>(std::move(state_machine));
+  replica->Start(server);
+  return replica;
+}
+
+}  // namespace rsm
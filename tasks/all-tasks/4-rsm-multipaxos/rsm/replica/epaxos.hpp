@@ -0,0 +1,15 @@
+#pragma once
+
+#include <rsm/replica/replica.hpp>
+#include <rsm/replica/state_machine.hpp>
+
+#include <commute/rpc/server.hpp>
+
+namespace rsm {
+
+// Leaderless replica (rsm.mode = epaxos), see readme
+
+IReplicaPtr MakeEPaxosReplica(IStateMachinePtr state_machine,
+                              commute::rpc::IServer* server);
+
+}  // namespace rsm
@@ -0,0 +1,312 @@
+#include <rsm/replica/epaxos/acceptor.hpp>
+
+#include <whirl/node/runtime/shortcuts.hpp>
+
+#include <timber/log.hpp>
+
+#include <string>
+
+using namespace whirl;
+
+namespace rsm {
+
+namespace epaxos {
+
+// Instances cached without spilling
+static const size_t kActiveInstances = 1024;
+
+static const std::string kMetaKey = "meta";
+
+static std::string InstanceKey(InstanceId slot) {
+  return std::to_string(slot);
+}
+
+Acceptor::Acceptor(size_t replicas, FootprintFunction footprint,
+                   CommittedCallback on_committed)
+    : replicas_(replicas),
+      footprint_(std::move(footprint)),
+      on_committed_(std::move(on_committed)),
+      meta_store_(node::rt::Database(), "epaxos"),
+      instance_store_(node::rt::Database(), "epaxos.instances"),
+      states_(kActiveInstances),
+      conflicts_(replicas),
+      logger_("EPaxos.Acceptor", node::rt::LoggerBackend()) {
+}
+
+void Acceptor::Recover() {
+  CommittedList committed;
+
+  {
+    auto guard = mutex_.Guard();
+
+    meta_ = meta_store_.GetOr(kMetaKey, Meta{});
+
+    for (InstanceId slot = 1; slot < meta_.horizon; ++slot) {
+      auto* state = TryState(slot);
+      if (state == nullptr) {
+        continue;
+      }
+      if (state->batch.has_value()) {
+        conflicts_.Record(slot, footprint_(*state->batch));
+      }
+      if (state->committed) {
+        committed.emplace_back(slot, state->vote->attrs);
+      }
+    }
+
+    LOG_INFO("Recovered instances below {}, committed: {}", meta_.horizon,
+             committed.size());
+  }
+
+  Notify(std::move(committed));
+}
+
+InstanceId Acceptor::Horizon() {
+  auto guard = mutex_.Guard();
+  return meta_.horizon;
+}
+
+Deps Acceptor::Lead(InstanceId slot, const ProposalNumber& n,
+                    const Batch& batch) {
+  auto guard = mutex_.Guard();
+
+  auto& state = State(slot);
+
+  // Conflicts before the batch itself is recorded
+  auto deps = conflicts_.Conflicts(footprint_(batch));
+
+  RecordBatch(slot, state, batch);
+  state.promise = n;
+  state.vote = Vote{n, {batch, deps}};
+  // Survives restart: slot is never reused, fast round vote is reported
+  // to recovery
+  Persist(slot, state);
+
+  return deps;
+}
+
+bool Acceptor::CommitFast(InstanceId slot) {
+  CommittedList committed;
+
+  {
+    auto guard = mutex_.Guard();
+
+    auto& state = State(slot);
+
+    if (state.committed || state.promise.round > 0 ||
+        !state.vote.has_value()) {
+      // Recovery may choose without the fast round quorum
+      return false;
+    }
+
+    SetCommitted(slot, state, state.vote->attrs, committed);
+  }
+
+  Notify(std::move(committed));
+  return true;
+}
+
+void Acceptor::MarkCommitted(InstanceId slot, const Attributes& attrs) {
+  CommittedList committed;
+
+  {
+    auto guard = mutex_.Guard();
+    SetCommitted(slot, State(slot), attrs, committed);
+  }
+
+  Notify(std::move(committed));
+}
+
+bool Acceptor::Unused(InstanceId slot) {
+  auto guard = mutex_.Guard();
+
+  auto* state = TryState(slot);
+  return state == nullptr || (!state->batch.has_value() && !state->committed);
+}
+
+std::optional<Footprint> Acceptor::Recorded(InstanceId slot) {
+  auto guard = mutex_.Guard();
+
+  auto* state = TryState(slot);
+  if (state == nullptr || !state->batch.has_value()) {
+    return std::nullopt;
+  }
+  return footprint_(*state->batch);
+}
+
+void Acceptor::PreAccept(const proto::PreAccept::Request& request,
+                         proto::PreAccept::Response* response) {
+  auto guard = mutex_.Guard();
+
+  auto& state = State(request.slot);
+
+  response->advice = state.promise;
+  response->deps = request.deps;
+
+  if (state.committed || state.promise.round > 0) {
+    // Slow or recovery round started, fast round is over
+    response->preempted = true;
+    return;
+  }
+
+  if (state.vote.has_value()) {
+    // Retried request
+    response->ack = true;
+    return;
+  }
+
+  if (state.batch.has_value()) {
+    // Retried request, rejected before: conflicts only grow.
+    // Reported conflicts may include the slot itself
+    Merge(response->deps, conflicts_.Conflicts(footprint_(request.batch)));
+    return;
+  }
+
+  auto local = conflicts_.Conflicts(footprint_(request.batch));
+
+  RecordBatch(request.slot, state, request.batch);
+
+  // Vote only if acceptor orders the batch exactly as the owner does
+  if (Covered(local, request.deps)) {
+    state.promise = request.n;
+    state.vote = Vote{request.n, {request.batch, request.deps}};
+    response->ack = true;
+  } else {
+    LOG_INFO("Conflicts in slot {} not known to owner", request.slot);
+    Merge(response->deps, local);
+  }
+
+  // Recorded batch should survive restart even without a vote
+  Persist(request.slot, state);
+}
+
+void Acceptor::Prepare(const proto::Prepare::Request& request,
+                       proto::Prepare::Response* response) {
+  auto guard = mutex_.Guard();
+
+  auto& state = State(request.slot);
+
+  if (request.n < state.promise) {
+    LOG_INFO("Reject Prepare({}, {}), promise: {}", request.slot, request.n,
+             state.promise);
+    response->ack = false;
+    response->advice = state.promise;
+    return;
+  }
+
+  if (state.promise < request.n) {
+    state.promise = request.n;
+    Persist(request.slot, state);
+  }
+
+  response->ack = true;
+  response->advice = state.promise;
+  response->node = node::rt::HostName();
+  response->vote = state.vote;
+  response->committed = state.committed;
+}
+
+void Acceptor::Accept(const proto::Accept::Request& request,
+                      proto::Accept::Response* response) {
+  auto guard = mutex_.Guard();
+
+  auto& state = State(request.slot);
+
+  const auto& proposal = request.proposal;
+
+  if (proposal.n < state.promise) {
+    LOG_INFO("Reject Accept({}, {}), promise: {}", request.slot, proposal.n,
+             state.promise);
+    response->ack = false;
+    response->advice = state.promise;
+    return;
+  }
+
+  if (!state.committed) {
+    RecordBatch(request.slot, state, proposal.attrs.batch);
+    state.promise = proposal.n;
+    state.vote = proposal;
+    Persist(request.slot, state);
+  }
+
+  response->ack = true;
+  response->advice = state.promise;
+}
+
+void Acceptor::Commit(const proto::Commit::Request& request,
+                      proto::Commit::Response* /*response*/) {
+  CommittedList committed;
+
+  {
+    auto guard = mutex_.Guard();
+    for (const auto& decision : request.decisions) {
+      SetCommitted(decision.slot, State(decision.slot), decision.attrs,
+                   committed);
+    }
+  }
+
+  Notify(std::move(committed));
+}
+
+Instance& Acceptor::State(InstanceId slot) {
+  if (auto* state = TryState(slot)) {
+    return *state;
+  }
+  return states_.Put(slot, Instance{});
+}
+
+Instance* Acceptor::TryState(InstanceId slot) {
+  if (auto* state = states_.Find(slot)) {
+    return state;
+  }
+  if (auto state = instance_store_.TryGet(InstanceKey(slot))) {
+    return &states_.Put(slot, std::move(*state));
+  }
+  return nullptr;
+}
+
+void Acceptor::Persist(InstanceId slot, const Instance& state) {
+  if (slot >= meta_.horizon) {
+    // Bounds recovery scan, moves in steps to keep it off the write path
+    meta_.horizon = slot + kActiveInstances;
+    meta_store_.Put(kMetaKey, meta_);
+  }
+  instance_store_.Put(InstanceKey(slot), state);
+}
+
+void Acceptor::RecordBatch(InstanceId slot, Instance& state,
+                           const Batch& batch) {
+  if (state.batch.has_value() || batch.IsNop()) {
+    return;
+  }
+  state.batch = batch;
+  conflicts_.Record(slot, footprint_(batch));
+}
+
+void Acceptor::SetCommitted(InstanceId slot, Instance& state,
+                            const Attributes& attrs,
+                            CommittedList& committed) {
+  if (state.committed) {
+    return;
+  }
+
+  RecordBatch(slot, state, attrs.batch);
+  // Any vote for the committed value is consistent with Paxos invariants
+  if (!state.vote.has_value() || !(state.vote->attrs == attrs)) {
+    state.vote = Vote{state.promise, attrs};
+  }
+  state.committed = true;
+  Persist(slot, state);
+
+  committed.emplace_back(slot, attrs);
+}
+
+void Acceptor::Notify(CommittedList committed) {
+  for (auto& [slot, attrs] : committed) {
+    on_committed_(slot, std::move(attrs));
+  }
+}
+
+}  // namespace epaxos
+
+}  // namespace rsm
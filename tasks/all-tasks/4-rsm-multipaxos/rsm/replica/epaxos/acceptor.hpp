@@ -0,0 +1,133 @@
+#pragma once
+
+#include <rsm/replica/epaxos/conflicts.hpp>
+#include <rsm/replica/epaxos/instance.hpp>
+#include <rsm/replica/epaxos/proto.hpp>
+#include <rsm/replica/paxos/instance_store.hpp>
+
+#include <commute/rpc/service_base.hpp>
+
+#include <whirl/node/store/kv.hpp>
+
+#include <await/fibers/sync/mutex.hpp>
+
+#include <muesli/serializable.hpp>
+
+#include <timber/logger.hpp>
+
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace rsm {
+
+namespace epaxos {
+
+// Acceptor role / RPC service for all instances on this node
+//
+// Besides Paxos state, acceptor records every batch it sees in the
+// conflict index: reported dependencies of later interfering batches
+// include it. Instance state is persisted in the node database,
+// the conflict index is rebuilt from it after restart
+
+class Acceptor : public commute::rpc::ServiceBase<Acceptor> {
+ public:
+  using FootprintFunction = std::function<Footprint(const Batch&)>;
+  // Invoked (without acceptor mutex) when instance is committed
+  using CommittedCallback = std::function<void(InstanceId, Attributes)>;
+
+  Acceptor(size_t replicas, FootprintFunction footprint,
+           CommittedCallback on_committed);
+
+  // Loads durable state, reports committed instances to callback
+  // One-shot
+  void Recover();
+
+  // Instances >= horizon are empty
+  InstanceId Horizon();
+
+  // Command leader
+
+  // Records batch in own slot and votes for it in fast round n,
+  // returns dependencies known locally
+  Deps Lead(InstanceId slot, const ProposalNumber& n, const Batch& batch);
+
+  // Commits own fast round vote, fails if a recovery round is promised
+  // in the slot: recovery may have chosen another value
+  bool CommitFast(InstanceId slot);
+
+  // Decision learned elsewhere (slow path, recovery, skipped own slots)
+  void MarkCommitted(InstanceId slot, const Attributes& attrs);
+
+  // Neither batch recorded nor decision known: own slot is not proposed
+  bool Unused(InstanceId slot);
+
+  // Footprint of the owner batch if it is recorded: only this batch
+  // or a no-op is ever committed in the slot
+  std::optional<Footprint> Recorded(InstanceId slot);
+
+ protected:
+  void RegisterMethods() override {
+    COMMUTE_RPC_REGISTER_HANDLER(PreAccept);
+    COMMUTE_RPC_REGISTER_HANDLER(Prepare);
+    COMMUTE_RPC_REGISTER_HANDLER(Accept);
+    COMMUTE_RPC_REGISTER_HANDLER(Commit);
+  }
+
+  void PreAccept(const proto::PreAccept::Request& request,
+                 proto::PreAccept::Response* response);
+
+  void Prepare(const proto::Prepare::Request& request,
+               proto::Prepare::Response* response);
+
+  void Accept(const proto::Accept::Request& request,
+              proto::Accept::Response* response);
+
+  void Commit(const proto::Commit::Request& request,
+              proto::Commit::Response* response);
+
+ private:
+  using CommittedList = std::vector<std::pair<InstanceId, Attributes>>;
+
+  struct Meta {
+    // Instances >= horizon are empty
+    InstanceId horizon = 1;
+
+    MUESLI_SERIALIZABLE(horizon)
+  };
+
+  // With mutex
+
+  Instance& State(InstanceId slot);
+  Instance* TryState(InstanceId slot);
+  void Persist(InstanceId slot, const Instance& state);
+
+  // Owner batch, no-ops carry no information
+  void RecordBatch(InstanceId slot, Instance& state, const Batch& batch);
+
+  void SetCommitted(InstanceId slot, Instance& state, const Attributes& attrs,
+                    CommittedList& committed);
+
+  // Without mutex
+  void Notify(CommittedList committed);
+
+ private:
+  const size_t replicas_;
+  FootprintFunction footprint_;
+  CommittedCallback on_committed_;
+
+  whirl::node::store::KVStore<Meta> meta_store_;
+  whirl::node::store::KVStore<Instance> instance_store_;
+
+  await::fibers::Mutex mutex_;
+  paxos::InstanceStore<Instance> states_;
+  ConflictIndex conflicts_;
+  Meta meta_;
+
+  timber::Logger logger_;
+};
+
+}  // namespace epaxos
+
+}  // namespace rsm
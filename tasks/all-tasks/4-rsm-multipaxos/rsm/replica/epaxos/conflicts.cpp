@@ -0,0 +1,76 @@
+#include <rsm/replica/epaxos/conflicts.hpp>
+
+#include <algorithm>
+
+namespace rsm {
+
+namespace epaxos {
+
+bool Interfere(const Footprint& lhs, const Footprint& rhs) {
+  if (!lhs.has_value() || !rhs.has_value()) {
+    // No-op interferes with nothing, even with a wildcard
+    bool nop = (lhs.has_value() && lhs->empty()) ||
+               (rhs.has_value() && rhs->empty());
+    return !nop;
+  }
+
+  // Sorted
+  auto l = lhs->begin();
+  auto r = rhs->begin();
+  while (l != lhs->end() && r != rhs->end()) {
+    if (*l < *r) {
+      ++l;
+    } else if (*r < *l) {
+      ++r;
+    } else {
+      return true;
+    }
+  }
+  return false;
+}
+
+ConflictIndex::ConflictIndex(size_t replicas)
+    : replicas_(replicas), any_(replicas, 0), wildcard_(replicas, 0) {
+}
+
+Deps ConflictIndex::Conflicts(const Footprint& footprint) const {
+  if (!footprint.has_value()) {
+    return any_;
+  }
+
+  Deps deps(replicas_, 0);
+  if (footprint->empty()) {
+    return deps;
+  }
+
+  Merge(deps, wildcard_);
+  for (const auto& key : *footprint) {
+    if (auto it = keys_.find(key); it != keys_.end()) {
+      Merge(deps, it->second);
+    }
+  }
+  return deps;
+}
+
+void ConflictIndex::Record(InstanceId slot, const Footprint& footprint) {
+  Raise(any_, slot);
+
+  if (!footprint.has_value()) {
+    Raise(wildcard_, slot);
+    return;
+  }
+
+  for (const auto& key : *footprint) {
+    auto [it, _] = keys_.try_emplace(key, replicas_, 0);
+    Raise(it->second, slot);
+  }
+}
+
+void ConflictIndex::Raise(Deps& deps, InstanceId slot) {
+  auto& max = deps[OwnerIndex(slot, replicas_)];
+  max = std::max(max, slot);
+}
+
+}  // namespace epaxos
+
+}  // namespace rsm
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <rsm/replica/epaxos/instance.hpp>
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rsm {
+
+namespace epaxos {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Keys touched by a batch, sorted and unique
+// std::nullopt = interferes with any batch, empty = with none (no-op)
+
+using Footprint = std::optional<std::vector<std::string>>;
+
+bool Interfere(const Footprint& lhs, const Footprint& rhs);
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Latest recorded slot per key and owner: dependencies of a new batch
+//
+// NOT thread-safe, external synchronization required
+
+class ConflictIndex {
+ public:
+  explicit ConflictIndex(size_t replicas);
+
+  // Interfering recorded batches
+  Deps Conflicts(const Footprint& footprint) const;
+
+  void Record(InstanceId slot, const Footprint& footprint);
+
+ private:
+  void Raise(Deps& deps, InstanceId slot);
+
+ private:
+  const size_t replicas_;
+
+  std::unordered_map<std::string, Deps> keys_;
+  // Any recorded batch
+  Deps any_;
+  // Batches with unknown footprint
+  Deps wildcard_;
+};
+
+}  // namespace epaxos
+
+}  // namespace rsm
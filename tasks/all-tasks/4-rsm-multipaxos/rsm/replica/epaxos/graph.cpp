@@ -0,0 +1,209 @@
+#include <rsm/replica/epaxos/graph.hpp>
+
+#include <algorithm>
+
+namespace rsm {
+
+namespace epaxos {
+
+ExecutionGraph::ExecutionGraph(size_t replicas)
+    : replicas_(replicas), executed_prefix_(replicas, 0) {
+}
+
+void ExecutionGraph::Commit(InstanceId slot, Attributes attrs,
+                            Footprint footprint) {
+  if (IsCommitted(slot)) {
+    return;
+  }
+  committed_.emplace(slot, Node{std::move(attrs), std::move(footprint)});
+}
+
+bool ExecutionGraph::IsCommitted(InstanceId slot) const {
+  return committed_.count(slot) > 0 || IsExecuted(slot);
+}
+
+auto ExecutionGraph::Drain(const RecordedFunction& recorded,
+                           std::set<InstanceId>& missing) -> Ready {
+  Pass pass{recorded, missing, {}, {}, 0, {}};
+
+  std::vector<InstanceId> roots;
+  roots.reserve(committed_.size());
+  for (const auto& [slot, _] : committed_) {
+    roots.push_back(slot);
+  }
+
+  for (auto root : roots) {
+    if (committed_.count(root) > 0 && pass.visits.count(root) == 0) {
+      Explore(root, pass);
+    }
+  }
+
+  return std::move(pass.ready);
+}
+
+void ExecutionGraph::Explore(InstanceId root, Pass& pass) {
+  struct Frame {
+    InstanceId slot;
+    std::vector<InstanceId> edges;
+    size_t next;
+  };
+
+  std::vector<Frame> frames;
+
+  auto enter = [&](InstanceId slot) {
+    Open(slot, pass);
+    bool blocked = false;
+    auto edges = Successors(slot, pass, blocked);
+    pass.visits.at(slot).blocked = blocked;
+    frames.push_back({slot, std::move(edges), 0});
+  };
+
+  enter(root);
+
+  while (!frames.empty()) {
+    auto& frame = frames.back();
+
+    if (frame.next < frame.edges.size()) {
+      auto next = frame.edges[frame.next++];
+      // References to map elements survive rehashing
+      auto& visit = pass.visits.at(frame.slot);
+
+      auto it = pass.visits.find(next);
+      if (it == pass.visits.end()) {
+        enter(next);
+      } else if (it->second.on_stack) {
+        visit.low = std::min(visit.low, it->second.index);
+      } else if (it->second.blocked) {
+        visit.blocked = true;
+      }
+      // Otherwise executed in this pass
+      continue;
+    }
+
+    auto slot = frame.slot;
+    frames.pop_back();
+
+    auto& visit = pass.visits.at(slot);
+    if (visit.low == visit.index) {
+      Close(slot, pass);
+    }
+
+    if (!frames.empty()) {
+      auto& parent = pass.visits.at(frames.back().slot);
+      parent.low = std::min(parent.low, visit.low);
+      if (!visit.on_stack && visit.blocked) {
+        parent.blocked = true;
+      }
+    }
+  }
+}
+
+std::vector<InstanceId> ExecutionGraph::Successors(InstanceId slot, Pass& pass,
+                                                   bool& blocked) {
+  const auto& node = committed_.at(slot);
+
+  std::vector<InstanceId> edges;
+
+  if (node.footprint.has_value() && node.footprint->empty()) {
+    return edges;  // No-op
+  }
+
+  const auto& deps = node.attrs.deps;
+
+  for (size_t q = 0; q < std::min(deps.size(), replicas_); ++q) {
+    for (auto dep = NextOwnSlot(q, executed_prefix_[q]); dep <= deps[q];
+         dep += replicas_) {
+      if (dep == slot || IsExecuted(dep)) {
+        continue;
+      }
+
+      if (auto it = committed_.find(dep); it != committed_.end()) {
+        if (Interfere(node.footprint, it->second.footprint)) {
+          edges.push_back(dep);
+        }
+        continue;
+      }
+
+      auto footprint = pass.recorded(dep);
+      if (footprint.has_value() && !Interfere(node.footprint, *footprint)) {
+        continue;
+      }
+
+      blocked = true;
+      pass.missing.insert(dep);
+    }
+  }
+
+  return edges;
+}
+
+void ExecutionGraph::Open(InstanceId slot, Pass& pass) {
+  auto index = pass.next_index++;
+  pass.visits.emplace(slot, Visit{index, index, true, false});
+  pass.stack.push_back(slot);
+}
+
+void ExecutionGraph::Close(InstanceId slot, Pass& pass) {
+  std::vector<InstanceId> component;
+  bool blocked = false;
+
+  while (true) {
+    auto member = pass.stack.back();
+    pass.stack.pop_back();
+
+    auto& visit = pass.visits.at(member);
+    visit.on_stack = false;
+    blocked = blocked || visit.blocked;
+
+    component.push_back(member);
+    if (member == slot) {
+      break;
+    }
+  }
+
+  if (blocked) {
+    for (auto member : component) {
+      pass.visits.at(member).blocked = true;
+    }
+    return;
+  }
+
+  std::sort(component.begin(), component.end());
+
+  for (auto member : component) {
+    auto it = committed_.find(member);
+    pass.ready.emplace_back(member, std::move(it->second.attrs.batch));
+    committed_.erase(it);
+    MarkExecuted(member);
+  }
+}
+
+bool ExecutionGraph::IsExecuted(InstanceId slot) const {
+  return slot <= executed_prefix_[OwnerIndex(slot, replicas_)] ||
+         executed_.count(slot) > 0;
+}
+
+void ExecutionGraph::MarkExecuted(InstanceId slot) {
+  executed_.insert(slot);
+
+  auto q = OwnerIndex(slot, replicas_);
+  auto& prefix = executed_prefix_[q];
+
+  while (true) {
+    auto next = NextOwnSlot(q, prefix);
+    auto it = executed_.find(next);
+    if (it == executed_.end()) {
+      break;
+    }
+    executed_.erase(it);
+    prefix = next;
+  }
+}
+
+InstanceId ExecutionGraph::NextOwnSlot(size_t q, InstanceId after) const {
+  return after == 0 ? q + 1 : after + replicas_;
+}
+
+}  // namespace epaxos
+
+}  // namespace rsm
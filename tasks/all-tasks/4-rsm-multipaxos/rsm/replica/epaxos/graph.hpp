@@ -0,0 +1,110 @@
+#pragma once
+
+#include <rsm/replica/epaxos/conflicts.hpp>
+#include <rsm/replica/epaxos/instance.hpp>
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace rsm {
+
+namespace epaxos {
+
+// Execution order of committed instances
+//
+// Instance a depends on instance b if b <= a.deps[owner(b)] and their
+// footprints interfere. Strongly connected components of the dependency
+// graph are executed in reverse topological order, instances within a
+// component in slot order. The graph of committed instances is the same
+// on every replica, and so is the order of interfering batches
+//
+// Component is executed once every instance it reaches is committed.
+// Uncommitted instance does not block execution if its recorded batch
+// does not interfere: it commits either with this batch or with a no-op
+//
+// NOT thread-safe, external synchronization required
+
+class ExecutionGraph {
+ public:
+  // Footprint of the recorded owner batch, see Acceptor::Recorded
+  using RecordedFunction = std::function<std::optional<Footprint>(InstanceId)>;
+
+  using Ready = std::vector<std::pair<InstanceId, Batch>>;
+
+  explicit ExecutionGraph(size_t replicas);
+
+  void Commit(InstanceId slot, Attributes attrs, Footprint footprint);
+
+  // Committed or executed
+  bool IsCommitted(InstanceId slot) const;
+
+  // Committed batches ready for execution, in execution order,
+  // marked as executed
+  // Uncommitted slots blocking execution are added to `missing`
+  Ready Drain(const RecordedFunction& recorded,
+              std::set<InstanceId>& missing);
+
+  // Committed, not executed
+  size_t Pending() const {
+    return committed_.size();
+  }
+
+ private:
+  struct Node {
+    Attributes attrs;
+    Footprint footprint;
+  };
+
+  // State of the current Drain pass
+  struct Visit {
+    size_t index;
+    size_t low;
+    bool on_stack;
+    // Reaches an uncommitted instance
+    bool blocked;
+  };
+
+  struct Pass {
+    const RecordedFunction& recorded;
+    std::set<InstanceId>& missing;
+    std::unordered_map<InstanceId, Visit> visits;
+    std::vector<InstanceId> stack;
+    size_t next_index = 0;
+    Ready ready;
+  };
+
+  // Tarjan, iterative: fibers have small stacks
+  void Explore(InstanceId root, Pass& pass);
+
+  // Dependencies of committed slot that are not executed yet
+  std::vector<InstanceId> Successors(InstanceId slot, Pass& pass,
+                                     bool& blocked);
+
+  void Open(InstanceId slot, Pass& pass);
+  // Pops component rooted at slot
+  void Close(InstanceId slot, Pass& pass);
+
+  bool IsExecuted(InstanceId slot) const;
+  void MarkExecuted(InstanceId slot);
+
+  // Own slots of replica q: q + 1, q + 1 + n, ...
+  InstanceId NextOwnSlot(size_t q, InstanceId after) const;
+
+ private:
+  const size_t replicas_;
+
+  std::map<InstanceId, Node> committed_;
+  // Own slots of replica q <= executed_prefix_[q] are executed
+  std::vector<InstanceId> executed_prefix_;
+  // Executed slots above prefixes
+  std::set<InstanceId> executed_;
+};
+
+}  // namespace epaxos
+
+}  // namespace rsm
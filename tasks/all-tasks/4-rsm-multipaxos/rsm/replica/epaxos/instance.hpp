@@ -0,0 +1,141 @@
+#pragma once
+
+#include <rsm/replica/batch.hpp>
+#include <rsm/replica/paxos/proposal.hpp>
+
+#include <muesli/serializable.hpp>
+
+#include <cereal/types/optional.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <algorithm>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace rsm {
+
+namespace epaxos {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Instances share the slot numbering of Mencius: slot i is owned by
+// replica (i - 1) mod n in the sorted list of replicas, the owner is
+// the command leader of every batch proposed in its slots
+
+using InstanceId = paxos::InstanceId;
+using paxos::ProposalNumber;
+
+inline size_t OwnerIndex(InstanceId slot, size_t replicas) {
+  return (slot - 1) % replicas;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Dependencies: deps[q] = max slot owned by replica q the batch depends on,
+// 0 = none. Batch is ordered after every interfering batch in slots of q
+// that are <= deps[q]
+//
+// Bound per replica instead of explicit list: interference is checked
+// against committed batches at execution time, so dependencies never
+// rely on transitivity through other instances (e.g. recovered no-ops)
+
+using Deps = std::vector<InstanceId>;
+
+// deps |= other
+inline void Merge(Deps& deps, const Deps& other) {
+  if (deps.size() < other.size()) {
+    deps.resize(other.size(), 0);
+  }
+  for (size_t q = 0; q < other.size(); ++q) {
+    deps[q] = std::max(deps[q], other[q]);
+  }
+}
+
+// lhs <= rhs componentwise
+inline bool Covered(const Deps& lhs, const Deps& rhs) {
+  for (size_t q = 0; q < lhs.size(); ++q) {
+    if (lhs[q] > (q < rhs.size() ? rhs[q] : 0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Value decided in an instance
+
+struct Attributes {
+  Batch batch;
+  Deps deps;
+
+  static Attributes Nop() {
+    return {};
+  }
+
+  MUESLI_SERIALIZABLE(batch, deps)
+};
+
+inline bool operator==(const Attributes& lhs, const Attributes& rhs) {
+  return lhs.batch == rhs.batch && lhs.deps == rhs.deps;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const Attributes& attrs) {
+  out << attrs.batch << " after {";
+  for (size_t q = 0; q < attrs.deps.size(); ++q) {
+    out << (q > 0 ? ", " : "") << attrs.deps[q];
+  }
+  return out << "}";
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Rounds of an instance, in proposal number order:
+//
+// 1) Fast round {0, owner}: PreAccept, owner proposes the batch with
+// conflicts known locally, acceptors vote only if they know no more
+// 2) Slow round {1, owner}: classic Phase 2 with dependencies merged
+// from a majority
+// 3) Recovery rounds {r >= 2, node}: classic Paxos by any replica,
+// finishes instances of a failed owner
+
+inline ProposalNumber FastRound(const std::string& owner) {
+  return {0, owner};
+}
+
+inline ProposalNumber SlowRound(const std::string& owner) {
+  return {1, owner};
+}
+
+static const uint64_t kFirstRecoveryRound = 2;
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct Vote {
+  ProposalNumber n;
+  Attributes attrs;
+
+  MUESLI_SERIALIZABLE(n, attrs)
+};
+
+// Durable acceptor state of an instance
+
+struct Instance {
+  // Batch seen in any request to the instance: recorded instances are
+  // included in dependencies of interfering batches
+  std::optional<Batch> batch;
+  // Do not accept proposals with numbers < promise
+  ProposalNumber promise;
+  // Last accepted proposal
+  std::optional<Vote> vote;
+  // Vote is known to be committed
+  bool committed = false;
+
+  MUESLI_SERIALIZABLE(batch, promise, vote, committed)
+};
+
+}  // namespace epaxos
+
+}  // namespace rsm
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <rsm/replica/epaxos/instance.hpp>
+
+#include <muesli/empty.hpp>
+#include <muesli/serializable.hpp>
+
+#include <cereal/types/optional.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rsm {
+
+namespace epaxos::proto {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fast round: owner proposes batch with dependencies known locally
+
+struct PreAccept {
+  struct Request {
+    InstanceId slot;
+    // Fast round of the owner
+    ProposalNumber n;
+    Batch batch;
+    Deps deps;
+
+    MUESLI_SERIALIZABLE(slot, n, batch, deps)
+  };
+
+  struct Response {
+    // Acceptor voted for the proposed attributes:
+    // it knows no interfering batch outside of request deps
+    bool ack = false;
+    ProposalNumber advice;
+    // Request deps + interfering batches known by acceptor
+    Deps deps;
+    // Recovery round is promised, no votes in the fast round
+    bool preempted = false;
+
+    MUESLI_SERIALIZABLE(ack, advice, deps, preempted)
+  };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Phase I of recovery rounds
+
+struct Prepare {
+  struct Request {
+    InstanceId slot;
+    ProposalNumber n;
+
+    MUESLI_SERIALIZABLE(slot, n)
+  };
+
+  struct Response {
+    bool ack = false;
+    ProposalNumber advice;
+    // Responding acceptor
+    std::string node;
+    std::optional<Vote> vote;
+    // Vote is committed
+    bool committed = false;
+
+    MUESLI_SERIALIZABLE(ack, advice, node, vote, committed)
+  };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Phase II of slow and recovery rounds
+
+struct Accept {
+  struct Request {
+    InstanceId slot;
+    Vote proposal;
+
+    MUESLI_SERIALIZABLE(slot, proposal)
+  };
+
+  struct Response {
+    bool ack = false;
+    ProposalNumber advice;
+
+    MUESLI_SERIALIZABLE(ack, advice)
+  };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Committed instances, fire-and-forget
+
+struct Commit {
+  struct Decision {
+    InstanceId slot;
+    Attributes attrs;
+
+    MUESLI_SERIALIZABLE(slot, attrs)
+  };
+
+  struct Request {
+    std::vector<Decision> decisions;
+
+    MUESLI_SERIALIZABLE(decisions)
+  };
+
+  using Response = muesli::EmptyMessage;
+};
+
+}  // namespace epaxos::proto
+
+}  // namespace rsm
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <rsm/replica/epaxos/proto.hpp>
+
+#include <whirl/node/runtime/shortcuts.hpp>
+
+#include <await/fibers/core/api.hpp>
+#include <await/futures/core/future.hpp>
+
+#include <wheels/result.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace rsm {
+
+namespace epaxos {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fast quorum: all replicas but one (the owner included)
+//
+// Recovery that does not hear from the owner sees at least
+// Majority - 1 fast round votes of a possibly committed batch,
+// so together with the owner a majority checked its dependencies
+
+inline size_t FastQuorum(size_t nodes) {
+  return std::max<size_t>(nodes, 2) - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Outcome of the fast round, see PreAcceptQuorum
+
+struct PreAcceptOutcome {
+  enum class Path {
+    // Fast quorum voted for the owner attributes
+    Fast,
+    // Majority reported dependencies, fast quorum is out of reach
+    Slow,
+    // Recovery round started or no majority
+    Failed,
+  };
+
+  Path path = Path::Failed;
+  // Dependencies merged over responses
+  Deps deps;
+};
+
+namespace detail {
+
+class PreAcceptCollector {
+  using Response = proto::PreAccept::Response;
+  using Outcome = PreAcceptOutcome;
+
+ public:
+  PreAcceptCollector(size_t total, size_t fast_acks, size_t slow_replies,
+                     await::futures::Promise<Outcome> promise)
+      : total_(total),
+        fast_acks_(fast_acks),
+        slow_replies_(slow_replies),
+        promise_(std::move(promise)) {
+  }
+
+  void Add(wheels::Result<Response> response) {
+    std::unique_lock lock(mutex_);
+
+    if (!promise_.has_value()) {
+      return;  // Already completed
+    }
+
+    ++done_;
+
+    if (response.IsOk()) {
+      if (response->preempted) {
+        Complete(lock, Outcome::Path::Failed);
+        return;
+      }
+      ++replies_;
+      Merge(outcome_.deps, response->deps);
+      if (response->ack) {
+        ++acks_;
+      }
+    }
+
+    if (acks_ >= fast_acks_) {
+      Complete(lock, Outcome::Path::Fast);
+    } else if (acks_ + (total_ - done_) < fast_acks_) {
+      // Fast quorum is out of reach
+      if (replies_ >= slow_replies_) {
+        Complete(lock, Outcome::Path::Slow);
+      } else if (done_ == total_) {
+        Complete(lock, Outcome::Path::Failed);
+      }
+    }
+  }
+
+  // Stop waiting for the fast quorum
+  void Expire() {
+    std::unique_lock lock(mutex_);
+
+    if (!promise_.has_value()) {
+      return;
+    }
+
+    Complete(lock, replies_ >= slow_replies_ ? Outcome::Path::Slow
+                                             : Outcome::Path::Failed);
+  }
+
+ private:
+  void Complete(std::unique_lock<std::mutex>& lock, Outcome::Path path) {
+    auto promise = std::move(*promise_);
+    promise_.reset();
+    auto outcome = std::move(outcome_);
+    outcome.path = path;
+    lock.unlock();
+
+    std::move(promise).SetValue(std::move(outcome));
+  }
+
+ private:
+  const size_t total_;
+  const size_t fast_acks_;
+  const size_t slow_replies_;
+
+  std::mutex mutex_;
+  size_t done_ = 0;
+  size_t replies_ = 0;
+  size_t acks_ = 0;
+  Outcome outcome_;
+  std::optional<await::futures::Promise<Outcome>> promise_;
+};
+
+}  // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fast round combinator over PreAccept responses of peers (owner excluded)
+//
+// Completes with Fast as soon as `fast_acks` peers voted, with Slow once
+// the fast quorum is out of reach or `timeout` expires and `slow_replies`
+// peers reported dependencies, with Failed otherwise
+
+inline await::futures::Future<PreAcceptOutcome> PreAcceptQuorum(
+    std::vector<await::futures::Future<proto::PreAccept::Response>> responses,
+    size_t fast_acks, size_t slow_replies, whirl::Jiffies timeout) {
+  auto [future, promise] = await::futures::MakeContract<PreAcceptOutcome>();
+
+  if (fast_acks == 0) {
+    // Owner vote is enough
+    PreAcceptOutcome outcome;
+    outcome.path = PreAcceptOutcome::Path::Fast;
+    std::move(promise).SetValue(std::move(outcome));
+    return std::move(future);
+  }
+
+  auto collector = std::make_shared<detail::PreAcceptCollector>(
+      responses.size(), fast_acks, slow_replies, std::move(promise));
+
+  for (auto& response : responses) {
+    std::move(response).Subscribe(
+        [collector](wheels::Result<proto::PreAccept::Response> result) {
+          collector->Add(std::move(result));
+        });
+  }
+
+  await::fibers::Go([collector, timeout]() {
+    whirl::node::rt::SleepFor(timeout);
+    collector->Expire();
+  });
+
+  return std::move(future);
+}
+
+}  // namespace epaxos
+
+}  // namespace rsm
@@ -1,5 +1,6 @@
 #include <rsm/replica/main.hpp>
 
+#include <rsm/replica/epaxos.hpp>
 #include <rsm/replica/multipaxos.hpp>
 #include <rsm/replica/service.hpp>
 
@@ -13,11 +14,21 @@ using namespace whirl;
 namespace rsm {
 
 void ReplicaMain(IStateMachinePtr state_machine) {
+  // Acceptor / proposer metadata
+  auto db_path = node::rt::Config()->GetString("db.path");
+  node::rt::Database()->Open(db_path);
+
   auto rpc_server = whirl::node::rpc::MakeServer(
       node::rt::Config()->GetInt<uint16_t>("rpc.port"));
 
-  auto replica =
-      rsm::MakeMultiPaxosReplica(std::move(state_machine), rpc_server.get());
+  // rsm.mode: leader / mencius -> MultiPaxos, epaxos -> leaderless
+  IReplicaPtr replica;
+  if (node::rt::Config()->GetString("rsm.mode") == "epaxos") {
+    replica = rsm::MakeEPaxosReplica(std::move(state_machine), rpc_server.get());
+  } else {
+    replica =
+        rsm::MakeMultiPaxosReplica(std::move(state_machine), rpc_server.get());
+  }
 
   auto service = std::make_shared<rsm::ReplicaService>(replica);
   rpc_server->RegisterService("RSM", service);
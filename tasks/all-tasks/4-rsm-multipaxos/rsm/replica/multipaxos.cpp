@@ -1,8 +1,19 @@
 #include <rsm/replica/multipaxos.hpp>
 
+#include <rsm/replica/apply.hpp>
+#include <rsm/replica/paxos/acceptor.hpp>
+#include <rsm/replica/paxos/backoff.hpp>
+#include <rsm/replica/paxos/instance_store.hpp>
+#include <rsm/replica/paxos/proposer.hpp>
+#include <rsm/replica/proto.hpp>
+#include <rsm/replica/session.hpp>
 #include <rsm/replica/store/log.hpp>
+#include <rsm/replica/store/snapshot.hpp>
+
+#include <muesli/serialize.hpp>
 
 #include <commute/rpc/call.hpp>
+#include <commute/rpc/service_base.hpp>
 
 #include <await/fibers/core/api.hpp>
 #include <await/fibers/sync/channel.hpp>
@@ -12,8 +23,16 @@
 
 #include <whirl/node/runtime/shortcuts.hpp>
 #include <whirl/node/cluster/peer.hpp>
+#include <whirl/node/store/kv.hpp>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
 
-using await::fibers::Channel;
 using await::futures::Future;
 using await::futures::Promise;
 
@@ -23,53 +42,1067 @@ namespace rsm {
 
 //////////////////////////////////////////////////////////////////////
 
-class MultiPaxos : public IReplica {
+class MultiPaxos : public IReplica,
+                   public commute::rpc::ServiceBase<MultiPaxos>,
+                   public node::cluster::Peer,
+                   public std::enable_shared_from_this<MultiPaxos> {
+  struct PendingCommand {
+    Command command;
+    Promise<Response> promise;
+  };
+
  public:
-  MultiPaxos(IStateMachinePtr state_machine, persist::fs::Path store_dir,
-             commute::rpc::IServer* server)
-      : state_machine_(std::move(state_machine)),
+  MultiPaxos(IStateMachinePtr state_machine, persist::fs::Path store_dir)
+      : Peer(node::rt::Config()),
+        state_machine_(std::move(state_machine)),
+        applier_(state_machine_,
+                 node::rt::Config()->GetInt<size_t>("rsm.apply.parallelism")),
+        sessions_(node::rt::Config()->GetInt<size_t>("rsm.sessions.max")),
         log_(store_dir),
+        snapshot_store_(node::rt::Database(), "rsm"),
+        reserved_store_(node::rt::Database(), "mencius"),
+        snapshot_slots_(
+            node::rt::Config()->GetInt<size_t>("rsm.snapshot.slots")),
+        snapshot_bytes_(
+            node::rt::Config()->GetInt<size_t>("rsm.snapshot.bytes")),
+        mencius_(node::rt::Config()->GetString("rsm.mode") == "mencius"),
+        acceptor_(std::make_shared<paxos::Acceptor>(
+            log_,
+            [this](paxos::InstanceId slot, paxos::Value value) {
+              Learn(slot, std::move(value));
+            },
+            [this](paxos::InstanceId slot, const paxos::ProposalNumber& n) {
+              ObserveAccepted(slot, n);
+            },
+            /*leases=*/!mencius_)),
+        lease_(node::rt::Config()->GetInt<uint64_t>("paxos.lease")),
+        revoke_timeout_(
+            mencius_ ? node::rt::Config()->GetInt<uint64_t>(
+                           "mencius.revoke.timeout")
+                     : 0),
+        commands_(kQueueCapacity),
+        window_(node::rt::Config()->GetInt<size_t>("paxos.window")),
+        batch_size_(node::rt::Config()->GetInt<size_t>("paxos.batch.size")),
+        batch_delay_(
+            node::rt::Config()->GetInt<uint64_t>("paxos.batch.delay")),
+        decisions_(kChosenWindow),
+        catchup_chunk_bytes_(
+            node::rt::Config()->GetInt<size_t>("rsm.catchup.chunk.bytes")),
+        chosen_(kChosenWindow),
         logger_("Replica", node::rt::LoggerBackend()) {
-    Start(server);
   }
 
   Future<Response> Execute(Command command) override {
     auto [future, promise] = await::futures::MakeContract<Response>();
 
-    LOG_INFO("Executing command {}", command);
-
     {
       auto guard = mutex_.Guard();
 
-      auto response = state_machine_->Apply(command);
-      std::move(promise).SetValue(Ack{response});
+      // Mencius: every replica proposes in its own slots
+      if (!mencius_ && !leader_.has_value()) {
+        std::move(promise).SetValue(RedirectResponse());
+        return std::move(future);
+      }
     }
 
+    LOG_INFO("Executing command {}", command);
+
+    commands_.Send({std::move(command), std::move(promise)});
+
     return std::move(future);
   };
 
-  void Start(commute::rpc::IServer* /*server*/) {
+  void Start(commute::rpc::IServer* server) {
     // Reset state machine state
     state_machine_->Reset();
 
+    // Slot owners in Mencius mode
+    replicas_ = ListPeers().WithMe();
+    std::sort(replicas_.begin(), replicas_.end());
+
     // Open log on disk
     log_.Open();
 
+    // Restore compacted prefix of the log
+    auto snapshot = snapshot_store_.GetOr(kSnapshotKey, Snapshot{});
+    if (snapshot.index > 0) {
+      state_machine_->InstallSnapshot(snapshot.state);
+      sessions_.Install(snapshot.sessions);
+      applied_ = snapshot_index_ = snapshot.index;
+      chosen_.Forget(applied_ + 1);
+    }
+
+    // Drains replayed log suffix
+    await::fibers::Go([this]() {
+      ApplyChosenCommands();
+    });
+
+    // Replay chosen suffix of the log
+    acceptor_->Recover(snapshot.index);
+
+    if (mencius_) {
+      // Own slots below horizon or reservation may hold votes cast before
+      // restart, they are never skipped or proposed again
+      auto guard = mutex_.Guard();
+      reserved_ = reserved_store_.GetOr(kReservedKey, 0);
+      next_slot_ = NextOwnSlot(
+          std::max({applied_ + 1, acceptor_->Horizon(), reserved_}));
+    }
+
     // Launch pipeline fibers
-    // ...
+    await::fibers::Go([this]() {
+      AssignSlots();
+    });
+
+    if (mencius_) {
+      await::fibers::Go([this]() {
+        RunRevocation();
+      });
+    } else {
+      await::fibers::Go([this]() {
+        RunLeaderElection();
+      });
+      await::fibers::Go([this]() {
+        RunCatchUp();
+      });
+    }
 
     // Register RPC services
-    // ...
+    server->RegisterService("Acceptor", acceptor_);
+    server->RegisterService("Replica", shared_from_this());
+  }
+
+ protected:
+  // RPC handlers
+
+  void RegisterMethods() override {
+    COMMUTE_RPC_REGISTER_HANDLER(Fetch);
+    COMMUTE_RPC_REGISTER_HANDLER(Announce);
+  }
+
+  // Serves lagging replicas: snapshot if `from` is compacted,
+  // then a chunk of chosen slots from the log
+  void Fetch(const proto::Fetch::Request& request,
+             proto::Fetch::Response* response) {
+    auto guard = mutex_.Guard();
+
+    auto from = request.from;
+
+    if (from <= snapshot_index_) {
+      response->snapshot = snapshot_store_.GetOr(kSnapshotKey, Snapshot{});
+      from = snapshot_index_ + 1;
+    }
+
+    size_t bytes = 0;
+    for (auto& [slot, value] :
+         acceptor_->ReadChosen(from, kFetchLimit, request.max_bytes)) {
+      bytes += value.Bytes();
+      response->decisions.push_back({slot, std::move(value)});
+    }
+
+    response->more = response->decisions.size() == kFetchLimit ||
+                     bytes >= request.max_bytes;
+  }
+
+  // Mencius: decisions of another slot owner
+  void Announce(const proto::Announce::Request& request,
+                proto::Announce::Response* /*response*/) {
+    ApplyAnnouncement(request);
+  }
+
+ private:
+  // Stable leader
+
+  // Leader sends heartbeats, followers watch the lease
+  // and compete for leadership when it expires
+  void RunLeaderElection() {
+    const Jiffies heartbeat_period = lease_.Count() / 4;
+
+    paxos::Backoff backoff{paxos::Backoff::Params::FromConfig()};
+
+    while (true) {
+      std::optional<paxos::ProposalNumber> ballot;
+      paxos::InstanceId committed;
+
+      {
+        auto guard = mutex_.Guard();
+        if (leader_.has_value()) {
+          ballot = leader_->n;
+          committed = leader_->committed;
+        }
+      }
+
+      if (ballot.has_value()) {
+        if (!proposer_.Heartbeat(*ballot, committed, heartbeat_period)) {
+          auto guard = mutex_.Guard();
+          StepDown(*ballot);
+        }
+        node::rt::SleepFor(heartbeat_period);
+        continue;
+      }
+
+      auto leader = acceptor_->Leader();
+
+      if (leader.has_value() && *leader != node::rt::HostName()) {
+        // Do not compete with the active leader
+        node::rt::SleepFor(heartbeat_period);
+        continue;
+      }
+
+      if (TryLead(lease_.Count() / 2)) {
+        backoff.Reset();
+      } else {
+        node::rt::SleepFor(backoff.Next());
+      }
+    }
+  }
+
+  // Phase 1 for all slots >= first unchosen slot
+  bool TryLead(Jiffies timeout) {
+    paxos::InstanceId from;
+
+    {
+      auto guard = mutex_.Guard();
+      from = applied_ + 1;
+    }
+
+    auto leadership = proposer_.Lead(from, timeout);
+
+    if (!leadership.has_value()) {
+      return false;
+    }
+
+    auto guard = mutex_.Guard();
+
+    if (leadership->compacted >= from) {
+      // Votes in slots <= compacted are lost on some acceptors,
+      // Phase 1 result is incomplete
+      LOG_INFO("Lagging behind compacted slot {}, catch up first",
+               leadership->compacted);
+      compacted_hint_ = std::max(compacted_hint_, leadership->compacted);
+      return false;
+    }
+
+    const auto n = leadership->n;
+
+    // Slots < from are chosen, no votes for n there
+    leader_.emplace(Leadership{n, from - 1, {}});
+
+    paxos::InstanceId last = from - 1;
+    if (!leadership->votes.empty()) {
+      last = std::max(last, leadership->votes.rbegin()->first);
+    }
+    next_slot_ = last + 1;
+
+    LOG_INFO("Became leader with {}, recover slots [{}, {}]", n, from, last);
+
+    // Finish slots possibly chosen by previous leaders,
+    // fill the rest with no-ops
+    for (auto slot = from; slot <= last; ++slot) {
+      if (slot <= applied_ || chosen_.Has(slot)) {
+        // Already chosen, not proposed with n
+        CommitOwn(n, slot);
+        continue;
+      }
+
+      // Empty batch = no-op
+      paxos::Proposal proposal{n, Batch{}};
+      if (auto vote = leadership->votes.find(slot);
+          vote != leadership->votes.end()) {
+        proposal.value = vote->second.value;
+      }
+
+      await::fibers::Go([this, slot, proposal = std::move(proposal)]() {
+        Replicate(slot, proposal);
+      });
+    }
+
+    return true;
+  }
+
+  // Phase 2 only
+  void Replicate(paxos::InstanceId slot, const paxos::Proposal& proposal) {
+    paxos::InstanceId committed = 0;
+
+    {
+      auto guard = mutex_.Guard();
+      if (leader_.has_value()) {
+        committed = leader_->committed;
+      }
+    }
+
+    bool chosen = proposer_.Accept(slot, proposal, committed);
+
+    {
+      auto guard = mutex_.Guard();
+      if (chosen) {
+        CommitOwn(proposal.n, slot);
+      } else {
+        StepDown(proposal.n);
+        return;
+      }
+    }
+
+    Learn(slot, proposal.value);
+  }
+
+  // With mutex
+  // Slot is chosen and all votes for n in it are for the chosen value
+  void CommitOwn(const paxos::ProposalNumber& n, paxos::InstanceId slot) {
+    if (!leader_.has_value() || leader_->n != n) {
+      return;
+    }
+
+    auto& ahead = leader_->committed_ahead;
+    ahead.insert(slot);
+    while (!ahead.empty() && *ahead.begin() == leader_->committed + 1) {
+      ahead.erase(ahead.begin());
+      ++leader_->committed;
+    }
+  }
+
+  // With mutex
+  void StepDown(const paxos::ProposalNumber& n) {
+    if (!leader_.has_value() || leader_->n != n) {
+      return;  // Already
+    }
+
+    LOG_INFO("Step down, ballot {}", n);
+
+    leader_.reset();
+
+    // Commands may still be chosen by the next leader,
+    // client retries them
+    for (auto& [_, waiters] : waiters_) {
+      for (auto& waiter : waiters) {
+        std::move(waiter.promise).SetValue(NotALeader{});
+      }
+    }
+    waiters_.clear();
+  }
+
+  // With mutex
+  Response RedirectResponse() {
+    auto leader = acceptor_->Leader();
+    if (leader.has_value() && *leader != node::rt::HostName()) {
+      return RedirectToLeader{*leader};
+    }
+    return NotALeader{};
+  }
+
+  // Pipeline
+
+  // 1) Assign batches of commands to slots in arrival order, keeping at most
+  // paxos.window Phase 2 instances in flight
+  //
+  // Commands arriving while the window is full join the next batch
+  void AssignSlots() {
+    while (true) {
+      std::vector<PendingCommand> batch;
+      batch.push_back(commands_.Receive());
+
+      // Acquire window slot, released when Phase 2 completes
+      window_.Send(true);
+
+      CollectBatch(batch);
+
+      auto guard = mutex_.Guard();
+
+      if (!mencius_ && !leader_.has_value()) {
+        for (auto& command : batch) {
+          std::move(command.promise).SetValue(RedirectResponse());
+        }
+        window_.Receive();
+        continue;
+      }
+
+      auto slot = next_slot_;
+      paxos::Proposal proposal;
+
+      if (mencius_) {
+        ReserveOwnSlot(slot);
+        next_slot_ = NextOwnSlot(slot + 1);
+        max_seen_ = std::max(max_seen_, slot);
+        proposal.n = OwnerBallot();
+      } else {
+        ++next_slot_;
+        proposal.n = leader_->n;
+      }
+
+      auto& waiters = waiters_[slot];
+      for (auto& command : batch) {
+        waiters.push_back(
+            {command.command.request_id, std::move(command.promise)});
+        proposal.value.commands.push_back(std::move(command.command));
+      }
+
+      LOG_INFO("Propose batch of {} commands in slot {}", batch.size(), slot);
+
+      // 2) Commit via consensus: slot i + 1 does not wait for slot i
+      await::fibers::Go([this, slot, proposal = std::move(proposal)]() {
+        if (mencius_) {
+          ReplicateOwned(slot, proposal);
+        } else {
+          Replicate(slot, proposal);
+        }
+        window_.Receive();
+      });
+    }
+  }
+
+  // Up to paxos.batch.size commands, waits at most paxos.batch.delay
+  // for more to arrive
+  void CollectBatch(std::vector<PendingCommand>& batch) {
+    DrainCommands(batch);
+
+    if (batch.size() < batch_size_ && batch_delay_.Count() > 0) {
+      node::rt::SleepFor(batch_delay_);
+      DrainCommands(batch);
+    }
+  }
+
+  void DrainCommands(std::vector<PendingCommand>& batch) {
+    while (batch.size() < batch_size_) {
+      auto command = commands_.TryReceive();
+      if (!command.has_value()) {
+        break;
+      }
+      batch.push_back(std::move(*command));
+    }
+  }
+
+  // Mencius
+  //
+  // Slot ownership rotates round-robin over replicas, every replica
+  // proposes commands in its own slots, there is no single leader.
+  // Owner skips Phase 1 in its slots and announces decisions to peers.
+  // Owner falling behind others skips its unused slots (no-ops),
+  // slots of a failed owner are revoked by peers with regular Paxos
+
+  const std::string& Owner(paxos::InstanceId slot) const {
+    return replicas_[(slot - 1) % replicas_.size()];
+  }
+
+  // First slot >= from owned by this replica
+  paxos::InstanceId NextOwnSlot(paxos::InstanceId from) const {
+    auto slot = std::max<paxos::InstanceId>(from, 1);
+    while (Owner(slot) != node::rt::HostName()) {
+      ++slot;
+    }
+    return slot;
+  }
+
+  // With mutex
+  // Local vote may not be persisted when the owner crashes, so the
+  // reservation is persisted before Accept is sent: otherwise the owner
+  // could propose another batch in the slot with the same ballot after
+  // restart. Moves in steps to keep it off the write path
+  void ReserveOwnSlot(paxos::InstanceId slot) {
+    if (slot >= reserved_) {
+      reserved_ = slot + kReservedSlots;
+      reserved_store_.Put(kReservedKey, reserved_);
+    }
+  }
+
+  // Round 0 is below any number of Proposer: only the owner proposes
+  // with it in its slots, no Phase 1 required
+  paxos::ProposalNumber OwnerBallot() const {
+    return {0, node::rt::HostName()};
+  }
+
+  // Phase 2 with owner ballot
+  void ReplicateOwned(paxos::InstanceId slot,
+                      const paxos::Proposal& proposal) {
+    if (!proposer_.Accept(slot, proposal, /*committed=*/0)) {
+      // Revoked by peers, commands may be chosen anyway, clients retry
+      auto guard = mutex_.Guard();
+      FailWaiters(slot);
+      return;
+    }
+
+    Learn(slot, proposal.value);
+    Broadcast({proposal.n, 0, 0, {slot}});
+  }
+
+  // Accepted proposal in slot => slots below are in use, skip unused
+  // own slots so that peers do not wait for them
+  void ObserveAccepted(paxos::InstanceId slot, const paxos::ProposalNumber& n) {
+    if (!mencius_ || n.node == node::rt::HostName()) {
+      return;
+    }
+
+    proto::Announce::Request skip{OwnerBallot(), 0, 0, {}};
+
+    {
+      auto guard = mutex_.Guard();
+
+      max_seen_ = std::max(max_seen_, slot);
+
+      if (next_slot_ > slot) {
+        return;  // Nothing to skip
+      }
+
+      // Vote in `slot` is persisted, own slots below it are never
+      // reused after restart
+      skip.skip_from = next_slot_;
+      skip.skip_to = slot;
+      next_slot_ = NextOwnSlot(slot);
+    }
+
+    LOG_INFO("Skip own slots [{}, {})", skip.skip_from, skip.skip_to);
+
+    Broadcast(skip);
+  }
+
+  // Without mutex
+  void Broadcast(const proto::Announce::Request& announce) {
+    ApplyAnnouncement(announce);
+
+    for (const auto& peer : ListPeers().WithoutMe()) {
+      await::fibers::Go([this, peer, announce]() {
+        // Lost announcement stalls peer until it revokes the slot
+        auto ack = await::fibers::Await(
+            commute::rpc::Call("Replica.Announce")
+                .Args(announce)
+                .Via(Channel(peer))
+                .Context(await::context::ThisFiber())
+                .AtMostOnce()
+                .Start()
+                .As<proto::Announce::Response>());
+        if (!ack.IsOk()) {
+          LOG_INFO("Failed to deliver announcement to {}", peer);
+        }
+      });
+    }
+  }
+
+  // Without mutex
+  void ApplyAnnouncement(const proto::Announce::Request& announce) {
+    acceptor_->CommitVotes(announce.n, announce.chosen);
+
+    // Only the owner proposes non-empty batches with its ballot, so the
+    // skipped slot can only be chosen with a no-op
+    //
+    // Recorded in the log as chosen: Replay and Fetch stop at the first
+    // slot that is not
+    for (auto slot = announce.skip_from; slot < announce.skip_to; ++slot) {
+      if (Owner(slot) == announce.n.node) {
+        acceptor_->MarkChosen(slot, Batch{});
+        Learn(slot, Batch{});
+      }
+    }
+  }
+
+  // Replica stuck on the same slot for mencius.revoke.timeout
+  // fetches missing slots from a peer and, if still stuck,
+  // revokes them
+  void RunRevocation() {
+    paxos::InstanceId last_applied = 0;
+    size_t stalls = 0;
+
+    while (true) {
+      node::rt::SleepFor(revoke_timeout_);
+
+      paxos::InstanceId from;
+      std::vector<paxos::InstanceId> slots;
+
+      {
+        auto guard = mutex_.Guard();
+
+        auto end = std::max(max_seen_ + 1, next_slot_);
+
+        if (applied_ != last_applied || applied_ + 1 >= end) {
+          // Progress or nothing to wait for
+          last_applied = applied_;
+          stalls = 0;
+          continue;
+        }
+
+        from = applied_ + 1;
+
+        if (++stalls % 2 == 0) {
+          for (auto slot = from; slot < end && slots.size() < kRevokeLimit;
+               ++slot) {
+            if (chosen_.Has(slot)) {
+              continue;
+            }
+            // In flight or unused own slots
+            if (Owner(slot) == node::rt::HostName() &&
+                (waiters_.count(slot) > 0 || slot >= next_slot_)) {
+              continue;
+            }
+            slots.push_back(slot);
+          }
+        }
+      }
+
+      if (slots.empty()) {
+        CatchUp(from);
+      } else {
+        Revoke(slots);
+      }
+    }
+  }
+
+  void Revoke(const std::vector<paxos::InstanceId>& slots) {
+    LOG_INFO("Revoke {} slots starting from {}", slots.size(), slots.front());
+
+    std::vector<Future<bool>> revoked;
+
+    for (auto slot : slots) {
+      auto [future, promise] = await::futures::MakeContract<bool>();
+      auto done = std::make_shared<Promise<bool>>(std::move(promise));
+
+      await::fibers::Go([this, slot, done]() {
+        // Owner vote or no-op
+        auto chosen = proposer_.TryPropose(slot, Batch{});
+        if (chosen.has_value()) {
+          acceptor_->MarkChosen(slot, *chosen);
+          Learn(slot, std::move(*chosen));
+        }
+        std::move(*done).SetValue(chosen.has_value());
+      });
+
+      revoked.push_back(std::move(future));
+    }
+
+    for (auto& future : revoked) {
+      await::fibers::Await(std::move(future)).ValueOrThrow();
+    }
+  }
+
+  // With mutex
+  void FailWaiters(paxos::InstanceId slot) {
+    if (auto it = waiters_.find(slot); it != waiters_.end()) {
+      for (auto& waiter : it->second) {
+        std::move(waiter.promise).SetValue(NotALeader{});
+      }
+      waiters_.erase(it);
+    }
+  }
+
+  // Catch-up
+
+  // Replica that missed Phase 2 messages never learns the missed slots
+  // from the leader commit index alone, fetch them from a peer
+  void RunCatchUp() {
+    const Jiffies period = lease_.Count() / 4;
+
+    paxos::InstanceId last_applied = 0;
+
+    while (true) {
+      node::rt::SleepFor(period);
+
+      paxos::InstanceId from;
+
+      {
+        auto guard = mutex_.Guard();
+
+        // Decisions may be in flight, wait for apply to stall
+        bool stalled = applied_ == last_applied;
+        last_applied = applied_;
+
+        auto target = std::max(acceptor_->CommittedHint(), compacted_hint_);
+
+        if (leader_.has_value() || !stalled || applied_ >= target) {
+          continue;
+        }
+
+        from = applied_ + 1;
+      }
+
+      CatchUp(from);
+    }
+  }
+
+  // Streams chosen slots >= from from a single peer in chunks of
+  // rsm.catchup.chunk.bytes until the peer runs out of chosen slots
+  //
+  // Next chunk is requested before the current one is persisted, so
+  // network and disk overlap. Flow control: one chunk in flight, and
+  // Learn blocks while kChosenWindow decisions wait for apply
+  void CatchUp(paxos::InstanceId from) {
+    auto peer = CatchUpSource();
+
+    LOG_INFO("Catch up from {}, slots >= {}", peer, from);
+
+    auto chunk = FetchChunk(peer, from);
+
+    size_t chunks = 0;
+
+    while (true) {
+      auto result = await::fibers::Await(std::move(chunk));
+
+      if (!result.IsOk()) {
+        return;  // Retry later
+      }
+
+      auto fetched = std::move(result).ValueOrThrow();
+      ++chunks;
+
+      if (fetched.snapshot.has_value()) {
+        InstallSnapshot(std::move(*fetched.snapshot));
+      }
+
+      if (fetched.decisions.empty()) {
+        break;
+      }
+
+      if (fetched.more) {
+        chunk = FetchChunk(peer, fetched.decisions.back().slot + 1);
+      }
+
+      for (auto& decision : fetched.decisions) {
+        // Survives restart, served to other lagging replicas
+        acceptor_->MarkChosen(decision.slot, decision.value);
+        Learn(decision.slot, std::move(decision.value));
+      }
+
+      if (!fetched.more) {
+        break;
+      }
+    }
+
+    LOG_INFO("Caught up from {} in {} chunks", peer, chunks);
+  }
+
+  Future<proto::Fetch::Response> FetchChunk(const std::string& peer,
+                                            paxos::InstanceId from) {
+    return commute::rpc::Call("Replica.Fetch")
+        .Args(proto::Fetch::Request{from, catchup_chunk_bytes_})
+        .Via(Channel(peer))
+        .Context(await::context::ThisFiber())
+        .AtMostOnce()
+        .Start()
+        .As<proto::Fetch::Response>();
+  }
+
+  // Leader holds the longest chosen prefix
+  std::string CatchUpSource() {
+    auto leader = acceptor_->Leader();
+    if (leader.has_value() && *leader != node::rt::HostName()) {
+      return *leader;
+    }
+    auto peers = ListPeers().WithoutMe();
+    return peers[node::rt::RandomIndex(peers.size())];
+  }
+
+  // Snapshots
+
+  // With mutex
+  bool SnapshotDue() const {
+    bool slots = snapshot_slots_ > 0 &&  //
+                 applied_ - snapshot_index_ >= snapshot_slots_;
+    bool bytes = snapshot_bytes_ > 0 &&  //
+                 bytes_since_snapshot_ >= snapshot_bytes_;
+    return slots || bytes;
+  }
+
+  // With apply_mutex_, without mutex_
+  // Applied prefix does not move while apply_mutex_ is held,
+  // so the state is captured without blocking Execute and RPC handlers
+  void TakeSnapshot() {
+    paxos::InstanceId index;
+    {
+      auto guard = mutex_.Guard();
+      index = applied_;
+    }
+
+    LOG_INFO("Take snapshot at slot {}", index);
+
+    Snapshot snapshot{index, state_machine_->MakeSnapshot(),
+                      sessions_.MakeSnapshot()};
+    // Atomic: either the old or the new snapshot survives crash
+    snapshot_store_.Put(kSnapshotKey, snapshot);
+
+    Compact(snapshot.index);
+  }
+
+  // Without mutex
+  void InstallSnapshot(Snapshot snapshot) {
+    auto apply_guard = apply_mutex_.Guard();
+
+    {
+      auto guard = mutex_.Guard();
+      if (snapshot.index <= applied_) {
+        return;  // Stale
+      }
+    }
+
+    LOG_INFO("Install snapshot for slots [1, {}]", snapshot.index);
+
+    // Persist snapshot before the log prefix is dropped
+    snapshot_store_.Put(kSnapshotKey, snapshot);
+
+    state_machine_->InstallSnapshot(snapshot.state);
+    sessions_.Install(snapshot.sessions);
+
+    {
+      auto guard = mutex_.Guard();
+
+      applied_ = snapshot.index;
+      chosen_.Forget(applied_ + 1);
+
+      // Results of commands in installed slots are unknown, clients retry
+      auto end = waiters_.upper_bound(applied_);
+      for (auto it = waiters_.begin(); it != end; ++it) {
+        for (auto& waiter : it->second) {
+          std::move(waiter.promise).SetValue(NotALeader{});
+        }
+      }
+      waiters_.erase(waiters_.begin(), end);
+    }
+
+    Compact(snapshot.index);
+  }
+
+  // With apply_mutex_, without mutex_
+  // Slots <= index are covered by the durable snapshot
+  void Compact(paxos::InstanceId index) {
+    {
+      auto guard = mutex_.Guard();
+      snapshot_index_ = index;
+      bytes_since_snapshot_ = 0;
+    }
+
+    // Log truncation, under the acceptor's own lock
+    acceptor_->Compact(index);
+  }
+
+  // Without mutex
+  void Learn(paxos::InstanceId slot, paxos::Value value) {
+    decisions_.Send({slot, std::move(value)});
+  }
+
+  // 3) Apply: chosen slots arrive out of order, buffered until
+  // the prefix is complete
+  void ApplyChosenCommands() {
+    while (true) {
+      auto decision = decisions_.Receive();
+
+      {
+        auto guard = mutex_.Guard();
+
+        if (decision.slot <= applied_ || chosen_.Has(decision.slot)) {
+          continue;  // Already known
+        }
+
+        chosen_.Put(decision.slot, std::move(decision.value));
+      }
+
+      ApplyChosen();
+    }
+  }
+
+  // With mutex
+  // Next slot of the chosen prefix, counted as applied once taken
+  std::optional<std::pair<paxos::InstanceId, paxos::Value>> TakeChosen() {
+    auto* batch = chosen_.Find(applied_ + 1);
+    if (batch == nullptr) {
+      return std::nullopt;
+    }
+    auto slot = ++applied_;
+    auto value = std::move(*batch);
+    chosen_.Erase(slot);
+    return std::make_pair(slot, std::move(value));
+  }
+
+  // Without mutex
+  // Applies chosen prefix of the log in slot order. State machine and
+  // session table are guarded by apply_mutex_, mutex_ is held only to
+  // take slots and resolve waiters
+  void ApplyChosen() {
+    auto apply_guard = apply_mutex_.Guard();
+
+    while (true) {
+      std::optional<std::pair<paxos::InstanceId, paxos::Value>> next;
+      {
+        auto guard = mutex_.Guard();
+        next = TakeChosen();
+      }
+      if (!next.has_value()) {
+        break;
+      }
+
+      auto slot = next->first;
+      const auto& batch = next->second;
+
+      std::map<RequestId, Response> responses;
+
+      // Exactly-once: retries are answered from the session table
+      std::vector<Command> fresh;
+      for (size_t i = 0; i < batch.commands.size(); ++i) {
+        const auto& command = batch.commands[i];
+        if (responses.count(command.request_id) > 0) {
+          continue;  // Retry within the batch
+        }
+        if (command.OpensSession()) {
+          // Position in the log makes the session id unique
+          auto client_id = SessionTable::MakeSessionId(command, slot, i);
+          sessions_.Open(client_id);
+          responses.emplace(command.request_id,
+                            Ack{muesli::Serialize(client_id)});
+          continue;
+        }
+        const auto& client_id = command.request_id.client_id;
+        if (!sessions_.Has(client_id)) {
+          // Evicted: the command may have been applied already
+          responses.emplace(command.request_id, SessionExpired{client_id});
+          continue;
+        }
+        sessions_.Acknowledge(command);
+        if (auto response = sessions_.Lookup(command.request_id)) {
+          responses.emplace(command.request_id, Ack{std::move(*response)});
+        } else {
+          // Placeholder, filled in once applied
+          responses.emplace(command.request_id, Ack{});
+          fresh.push_back(command);
+        }
+      }
+
+      // Unpack batch, results as if applied in order
+      auto results = applier_.Apply(fresh);
+
+      size_t bytes = 0;
+      for (size_t i = 0; i < results.size(); ++i) {
+        const auto& command = fresh[i];
+        sessions_.Record(command.request_id, results[i]);
+        responses.insert_or_assign(command.request_id,
+                                   Ack{std::move(results[i])});
+        bytes += command.request.size();
+      }
+
+      auto guard = mutex_.Guard();
+
+      bytes_since_snapshot_ += bytes;
+
+      if (auto it = waiters_.find(slot); it != waiters_.end()) {
+        for (auto& waiter : it->second) {
+          if (auto response = responses.find(waiter.request_id);
+              response != responses.end()) {
+            std::move(waiter.promise).SetValue(response->second);
+          } else {
+            // Slot was taken over by another leader
+            std::move(waiter.promise).SetValue(NotALeader{});
+          }
+        }
+        waiters_.erase(it);
+      }
+    }
+
+    bool snapshot_due;
+    {
+      auto guard = mutex_.Guard();
+      snapshot_due = SnapshotDue();
+    }
+
+    if (snapshot_due) {
+      TakeSnapshot();
+    }
   }
 
  private:
+  // Chosen, not yet applied slots buffered in memory
+  static const size_t kChosenWindow = 1024;
+  static const size_t kQueueCapacity = 1024;
+  // Slots per Fetch chunk, bounds chunks of no-ops
+  static const size_t kFetchLimit = 1024;
+  // Slots per revocation round
+  static const size_t kRevokeLimit = 64;
+
+  // Mencius: slots per own slots reservation
+  static const size_t kReservedSlots = 256;
+
+  static inline const std::string kSnapshotKey = "snapshot";
+  static inline const std::string kReservedKey = "reserved";
+
+  struct Decision {
+    paxos::InstanceId slot;
+    paxos::Value value;
+  };
+
+  struct Leadership {
+    paxos::ProposalNumber n;
+    // Advertised to acceptors: votes for n in slots <= committed are chosen
+    //
+    // Covers only slots chosen by our own Phase 2 (or not proposed with n
+    // at all): a slot chosen by a newer leader may hold a stale vote for n
+    paxos::InstanceId committed;
+    std::set<paxos::InstanceId> committed_ahead;
+  };
+
+  struct Waiter {
+    RequestId request_id;
+    Promise<Response> promise;
+  };
+
   // Replicated state
   IStateMachinePtr state_machine_;
+  // rsm.apply.parallelism
+  Applier applier_;
+  // rsm.sessions.max
+  SessionTable sessions_;
 
   // Persistent log
   Log log_;
 
+  // Compacted prefix of the log
+  node::store::KVStore<Snapshot> snapshot_store_;
+  // Mencius: own slots < reserved_ may have been proposed
+  node::store::KVStore<paxos::InstanceId> reserved_store_;
+  // rsm.snapshot.{slots, bytes}, 0 = disabled
+  const size_t snapshot_slots_;
+  const size_t snapshot_bytes_;
+
+  // rsm.mode = leader | mencius
+  const bool mencius_;
+  // Sorted, slot owners
+  std::vector<std::string> replicas_;
+
+  // Single-Decree Paxos instance per slot
+  std::shared_ptr<paxos::Acceptor> acceptor_;
+  paxos::Proposer proposer_;
+
+  // paxos.lease
+  const Jiffies lease_;
+  // mencius.revoke.timeout
+  const Jiffies revoke_timeout_;
+
+  // Pipeline stages
+  await::fibers::Channel<PendingCommand> commands_;
+  // Semaphore, capacity = paxos.window
+  await::fibers::Channel<bool> window_;
+  // paxos.batch.{size, delay}
+  const size_t batch_size_;
+  const Jiffies batch_delay_;
+  await::fibers::Channel<Decision> decisions_;
+  // rsm.catchup.chunk.bytes
+  const size_t catchup_chunk_bytes_;
+
+  // Serializes access to the state machine and the session table:
+  // apply, snapshot take and install. Acquired before mutex_
+  await::fibers::Mutex apply_mutex_;
+
   await::fibers::Mutex mutex_;
+  // Set while this replica is the leader
+  std::optional<Leadership> leader_;
+  // Mencius: next own slot
+  paxos::InstanceId next_slot_ = 1;
+  // Mencius: persisted bound of own slots in use
+  paxos::InstanceId reserved_ = 0;
+  // Mencius: max slot in use
+  paxos::InstanceId max_seen_ = 0;
+  // Last applied slot, advanced when the slot is taken for apply
+  paxos::InstanceId applied_ = 0;
+  paxos::InstanceStore<paxos::Value> chosen_;
+  // Slots <= snapshot_index_ are compacted
+  paxos::InstanceId snapshot_index_ = 0;
+  // Command payload applied since the last snapshot
+  size_t bytes_since_snapshot_ = 0;
+  // Max compacted slot reported by acceptors
+  paxos::InstanceId compacted_hint_ = 0;
+  // Slot -> pending Execute calls
+  std::map<paxos::InstanceId, std::vector<Waiter>> waiters_;
 
   // Logging
   timber::Logger logger_;
@@ -82,8 +1115,10 @@ IReplicaPtr MakeMultiPaxosReplica(IStateMachinePtr state_machine,
   auto store_dir =
       node::rt::Fs()->MakePath(node::rt::Config()->GetString("rsm.store.dir"));
 
-  return std::make_shared<MultiPaxos>(std::move(state_machine),
-                                      std::move(store_dir), server);
+  auto replica = std::make_shared<MultiPaxos>(std::move(state_machine),
+                                              std::move(store_dir));
+  replica->Start(server);
+  return replica;
 }
 
 }  // namespace rsm
@@ -0,0 +1,406 @@
+#include <rsm/replica/paxos/acceptor.hpp>
+
+#include <whirl/node/runtime/shortcuts.hpp>
+
+#include <timber/log.hpp>
+
+#include <algorithm>
+
+using namespace whirl;
+
+namespace rsm {
+
+namespace paxos {
+
+// Instances cached without spilling
+static const size_t kActiveInstances = 1024;
+
+static const std::string kMetaKey = "meta";
+
+static uint64_t Now() {
+  return node::rt::MonotonicNow().ToJiffies().Count();
+}
+
+Acceptor::Acceptor(Log& log, ChosenCallback on_chosen,
+                   AcceptedCallback on_accepted, bool leases)
+    : log_(log),
+      on_chosen_(std::move(on_chosen)),
+      on_accepted_(std::move(on_accepted)),
+      leases_(leases),
+      lease_(node::rt::Config()->GetInt<uint64_t>("paxos.lease")),
+      meta_store_(node::rt::Database(), "acceptor"),
+      states_(kActiveInstances),
+      logger_("Paxos.Acceptor", node::rt::LoggerBackend()) {
+}
+
+void Acceptor::Recover(InstanceId compacted) {
+  ChosenList chosen;
+
+  {
+    auto guard = mutex_.Guard();
+
+    meta_ = meta_store_.GetOr(kMetaKey, Meta{});
+
+    // Lease granted before restart is unknown, do not grant another one
+    // until it expires
+    lease_until_ = Now() + lease_.Count();
+
+    // Snapshot is persisted before the log prefix is truncated,
+    // finish truncation interrupted by restart
+    compacted_ = chosen_prefix_ = compacted;
+    if (compacted > 0) {
+      log_.TruncatePrefix(compacted + 1);
+    }
+
+    while (auto* state = TryState(chosen_prefix_ + 1)) {
+      if (!state->chosen) {
+        break;
+      }
+      chosen.emplace_back(++chosen_prefix_, state->vote->value);
+    }
+
+    LOG_INFO("Recovered chosen prefix: {}, promise: {}", chosen_prefix_,
+             meta_.promise);
+  }
+
+  Notify(std::move(chosen));
+}
+
+InstanceId Acceptor::CommittedHint() {
+  auto guard = mutex_.Guard();
+  return committed_hint_;
+}
+
+InstanceId Acceptor::Horizon() {
+  auto guard = mutex_.Guard();
+  return meta_.horizon;
+}
+
+void Acceptor::CommitVotes(const ProposalNumber& n,
+                           const std::vector<InstanceId>& instances) {
+  ChosenList chosen;
+
+  {
+    auto guard = mutex_.Guard();
+
+    for (auto instance : instances) {
+      if (IsCompacted(instance)) {
+        continue;
+      }
+      auto* state = TryState(instance);
+      if (state == nullptr || state->chosen) {
+        continue;
+      }
+      if (state->vote.has_value() && state->vote->n == n) {
+        state->chosen = true;
+        Persist(instance, *state);
+        chosen.emplace_back(instance, state->vote->value);
+      }
+    }
+
+    while (auto* state = TryState(chosen_prefix_ + 1)) {
+      if (!state->chosen) {
+        break;
+      }
+      ++chosen_prefix_;
+    }
+  }
+
+  Notify(std::move(chosen));
+}
+
+void Acceptor::Compact(InstanceId compacted) {
+  auto guard = mutex_.Guard();
+
+  if (compacted <= compacted_) {
+    return;
+  }
+
+  LOG_INFO("Compact log prefix [1, {}]", compacted);
+
+  compacted_ = compacted;
+  chosen_prefix_ = std::max(chosen_prefix_, compacted);
+  log_.TruncatePrefix(compacted + 1);
+  states_.Forget(compacted + 1);
+}
+
+void Acceptor::MarkChosen(InstanceId instance, const Value& value) {
+  auto guard = mutex_.Guard();
+
+  if (IsCompacted(instance)) {
+    return;
+  }
+
+  auto& state = State(instance);
+
+  if (state.chosen) {
+    return;
+  }
+
+  // Any vote for the chosen value is consistent with Paxos invariants:
+  // proposals with numbers >= the chosen one carry the same value
+  state.vote = Proposal{state.promise, value};
+  state.chosen = true;
+  Persist(instance, state);
+
+  while (auto* next = TryState(chosen_prefix_ + 1)) {
+    if (!next->chosen) {
+      break;
+    }
+    ++chosen_prefix_;
+  }
+}
+
+std::vector<std::pair<InstanceId, Value>> Acceptor::ReadChosen(
+    InstanceId from, size_t limit, size_t max_bytes) {
+  auto guard = mutex_.Guard();
+
+  std::vector<std::pair<InstanceId, Value>> entries;
+  size_t bytes = 0;
+
+  for (auto instance = std::max(from, compacted_ + 1);
+       entries.size() < limit && (entries.empty() || bytes < max_bytes);
+       ++instance) {
+    auto entry = log_.Read(instance);
+    if (!entry.has_value() || !entry->chosen) {
+      break;
+    }
+    // Bypass cache: catch-up reads are cold
+    bytes += entry->vote->value.Bytes();
+    entries.emplace_back(instance, std::move(entry->vote->value));
+  }
+
+  return entries;
+}
+
+std::optional<std::string> Acceptor::Leader() {
+  auto guard = mutex_.Guard();
+  if (Now() < lease_until_ && !lease_holder_.empty()) {
+    return lease_holder_;
+  }
+  return std::nullopt;
+}
+
+void Acceptor::Prepare(const proto::Prepare::Request& request,
+                       proto::Prepare::Response* response) {
+  auto guard = mutex_.Guard();
+
+  if (IsCompacted(request.instance)) {
+    response->ack = false;
+    response->advice = meta_.promise;
+    return;
+  }
+
+  auto& state = State(request.instance);
+
+  // Repeated Prepare with the same number is acknowledged again
+  if (request.n < Promise(state) || Fenced(request.n)) {
+    LOG_INFO("Reject Prepare({}, {}), promise: {}", request.instance,
+             request.n, Promise(state));
+    response->ack = false;
+    response->advice = Promise(state);
+    return;
+  }
+
+  // Do not rewrite unchanged state
+  if (state.promise < request.n) {
+    state.promise = request.n;
+    // Promise (and reported vote) should survive restart
+    Persist(request.instance, state);
+  }
+
+  response->ack = true;
+  response->advice = state.promise;
+  response->vote = state.vote;
+}
+
+void Acceptor::Accept(const proto::Accept::Request& request,
+                      proto::Accept::Response* response) {
+  ChosenList chosen;
+
+  {
+    auto guard = mutex_.Guard();
+
+    if (IsCompacted(request.instance)) {
+      response->ack = false;
+      response->advice = meta_.promise;
+      return;
+    }
+
+    auto& state = State(request.instance);
+
+    const auto& proposal = request.proposal;
+
+    if (proposal.n < Promise(state)) {
+      LOG_INFO("Reject Accept({}, {}), promise: {}", request.instance,
+               proposal, Promise(state));
+      response->ack = false;
+      response->advice = Promise(state);
+      return;
+    }
+
+    // Retried Accept does not change state
+    bool same_vote = state.vote.has_value() && state.vote->n == proposal.n &&
+                     state.vote->value == proposal.value;
+
+    if (!same_vote || state.promise != proposal.n) {
+      LOG_INFO("Accept {} in instance {}", proposal, request.instance);
+
+      state.promise = proposal.n;
+      state.vote = proposal;
+      Persist(request.instance, state);
+    }
+
+    response->ack = true;
+    response->advice = state.promise;
+
+    GrantLease(proposal.n);
+    Commit(proposal.n, request.committed, chosen);
+  }
+
+  on_accepted_(request.instance, request.proposal.n);
+
+  Notify(std::move(chosen));
+}
+
+void Acceptor::MultiPrepare(const proto::MultiPrepare::Request& request,
+                            proto::MultiPrepare::Response* response) {
+  auto guard = mutex_.Guard();
+
+  if (request.n < meta_.promise || Fenced(request.n)) {
+    LOG_INFO("Reject MultiPrepare({}), promise: {}, lease holder: {}",
+             request.n, meta_.promise, lease_holder_);
+    response->ack = false;
+    response->advice = meta_.promise;
+    return;
+  }
+
+  if (meta_.promise < request.n) {
+    meta_.promise = request.n;
+    meta_store_.Put(kMetaKey, meta_);
+  }
+
+  GrantLease(request.n);
+
+  // Candidate lagging behind the snapshot should catch up first
+  response->compacted = compacted_;
+
+  for (auto instance = std::max(request.from, compacted_ + 1);
+       instance < meta_.horizon; ++instance) {
+    auto* state = TryState(instance);
+    if (state != nullptr && state->vote.has_value()) {
+      response->votes.push_back({instance, *state->vote});
+    }
+  }
+
+  LOG_INFO("Promise {} for instances >= {}, votes: {}", request.n,
+           request.from, response->votes.size());
+
+  response->ack = true;
+  response->advice = meta_.promise;
+}
+
+void Acceptor::Heartbeat(const proto::Heartbeat::Request& request,
+                         proto::Heartbeat::Response* response) {
+  ChosenList chosen;
+
+  {
+    auto guard = mutex_.Guard();
+
+    if (request.n < meta_.promise) {
+      response->ack = false;
+      response->advice = meta_.promise;
+      return;
+    }
+
+    GrantLease(request.n);
+    Commit(request.n, request.committed, chosen);
+
+    response->ack = true;
+    response->advice = meta_.promise;
+  }
+
+  Notify(std::move(chosen));
+}
+
+LogEntry& Acceptor::State(InstanceId instance) {
+  if (auto* state = TryState(instance)) {
+    return *state;
+  }
+  return states_.Put(instance, LogEntry::Empty());
+}
+
+LogEntry* Acceptor::TryState(InstanceId instance) {
+  if (auto* state = states_.Find(instance)) {
+    return state;
+  }
+  if (auto entry = log_.Read(instance)) {
+    return &states_.Put(instance, std::move(*entry));
+  }
+  return nullptr;
+}
+
+void Acceptor::Persist(InstanceId instance, const LogEntry& state) {
+  if (instance >= meta_.horizon) {
+    // Bounds MultiPrepare scan after restart,
+    // moves in steps to keep it off the write path
+    meta_.horizon = instance + kActiveInstances;
+    meta_store_.Put(kMetaKey, meta_);
+  }
+  log_.Update(instance, state);
+}
+
+ProposalNumber Acceptor::Promise(const LogEntry& state) const {
+  return std::max(state.promise, meta_.promise);
+}
+
+bool Acceptor::Fenced(const ProposalNumber& n) {
+  return leases_ && Now() < lease_until_ && n.node != lease_holder_;
+}
+
+void Acceptor::GrantLease(const ProposalNumber& n) {
+  if (!leases_) {
+    return;
+  }
+  lease_holder_ = n.node;
+  lease_until_ = Now() + lease_.Count();
+}
+
+void Acceptor::Commit(const ProposalNumber& n, InstanceId committed,
+                      ChosenList& chosen) {
+  committed_hint_ = std::max(committed_hint_, committed);
+
+  // Bound work per request, lagging acceptor catches up gradually
+  auto end = std::min(committed, chosen_prefix_ + kActiveInstances);
+
+  for (auto instance = chosen_prefix_ + 1; instance <= end; ++instance) {
+    // Cache empty instances as well, they are rescanned until chosen
+    auto& state = State(instance);
+    if (state.chosen) {
+      continue;
+    }
+    // Leader proposes single value per instance
+    if (state.vote.has_value() && state.vote->n == n) {
+      state.chosen = true;
+      Persist(instance, state);
+      chosen.emplace_back(instance, state.vote->value);
+    }
+  }
+
+  while (auto* state = TryState(chosen_prefix_ + 1)) {
+    if (!state->chosen) {
+      break;
+    }
+    ++chosen_prefix_;
+  }
+}
+
+void Acceptor::Notify(ChosenList chosen) {
+  for (auto& [instance, value] : chosen) {
+    on_chosen_(instance, std::move(value));
+  }
+}
+
+}  // namespace paxos
+
+}  // namespace rsm
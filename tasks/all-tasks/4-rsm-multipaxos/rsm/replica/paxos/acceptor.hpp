@@ -0,0 +1,180 @@
+#pragma once
+
+#include <rsm/replica/paxos/instance_store.hpp>
+#include <rsm/replica/paxos/proposal.hpp>
+#include <rsm/replica/paxos/proto.hpp>
+#include <rsm/replica/store/log.hpp>
+
+#include <commute/rpc/service_base.hpp>
+
+#include <whirl/node/store/kv.hpp>
+#include <whirl/node/time/jiffies.hpp>
+
+#include <await/fibers/sync/mutex.hpp>
+
+#include <muesli/serializable.hpp>
+
+#include <timber/logger.hpp>
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rsm {
+
+namespace paxos {
+
+// Acceptor role / RPC service for all instances on this node
+//
+// State of instance i is persisted in log entry i,
+// recently touched instances are cached in memory
+//
+// Leader lease: after MultiPrepare / Heartbeat / Accept from proposer P
+// acceptor rejects Phase 1 from other proposers for paxos.lease jiffies.
+// Lease only keeps proposers from competing, safety does not depend on it
+// Leases are disabled with rotating slot owners (Mencius), owners never
+// compete in their own slots
+
+class Acceptor : public commute::rpc::ServiceBase<Acceptor> {
+ public:
+  // Invoked (without acceptor mutex) when vote in instance is known to be chosen
+  using ChosenCallback = std::function<void(InstanceId, Value)>;
+  // Invoked (without acceptor mutex) when proposal is accepted in instance
+  using AcceptedCallback =
+      std::function<void(InstanceId, const ProposalNumber&)>;
+
+  // Log should outlive acceptor
+  Acceptor(Log& log, ChosenCallback on_chosen, AcceptedCallback on_accepted,
+           bool leases);
+
+  // Loads durable state, reports chosen log entries after
+  // compacted prefix [1, compacted] to callback
+  // One-shot, log should be opened
+  void Recover(InstanceId compacted);
+
+  // Holder of the active lease granted by this acceptor
+  std::optional<std::string> Leader();
+
+  // Max commit index received from leaders
+  InstanceId CommittedHint();
+
+  // Instances >= horizon are empty
+  InstanceId Horizon();
+
+  // Votes for n in `instances` are chosen (announced by proposer)
+  void CommitVotes(const ProposalNumber& n,
+                   const std::vector<InstanceId>& instances);
+
+  // Log compaction
+
+  // Instances <= compacted are chosen and covered by a durable snapshot:
+  // drop their state, reject further requests to them
+  void Compact(InstanceId compacted);
+
+  // Persist chosen value learned elsewhere (leader Phase 2, catch-up),
+  // chosen log entries are replayed after restart and served to peers
+  void MarkChosen(InstanceId instance, const Value& value);
+
+  // Up to `limit` chosen instances starting from `from`, at least one
+  // and at most `max_bytes` of command payload (see Batch::Bytes),
+  // stops at the first instance not known to be chosen
+  std::vector<std::pair<InstanceId, Value>> ReadChosen(InstanceId from,
+                                                       size_t limit,
+                                                       size_t max_bytes);
+
+ protected:
+  void RegisterMethods() override {
+    COMMUTE_RPC_REGISTER_HANDLER(Prepare);
+    COMMUTE_RPC_REGISTER_HANDLER(Accept);
+    COMMUTE_RPC_REGISTER_HANDLER(MultiPrepare);
+    COMMUTE_RPC_REGISTER_HANDLER(Heartbeat);
+  }
+
+  // Phase 1 (Prepare / Promise)
+
+  void Prepare(const proto::Prepare::Request& request,
+               proto::Prepare::Response* response);
+
+  // Phase 2 (Accept / Accepted)
+
+  void Accept(const proto::Accept::Request& request,
+              proto::Accept::Response* response);
+
+  // Stable leader
+
+  void MultiPrepare(const proto::MultiPrepare::Request& request,
+                    proto::MultiPrepare::Response* response);
+
+  void Heartbeat(const proto::Heartbeat::Request& request,
+                 proto::Heartbeat::Response* response);
+
+ private:
+  using ChosenList = std::vector<std::pair<InstanceId, Value>>;
+
+  // Durable state shared by all instances
+  struct Meta {
+    // Promise for every instance, see MultiPrepare
+    ProposalNumber promise;
+    // Instances >= horizon are empty
+    InstanceId horizon = 1;
+
+    MUESLI_SERIALIZABLE(promise, horizon)
+  };
+
+  // With mutex
+
+  LogEntry& State(InstanceId instance);
+  // nullptr for empty instance, does not populate cache
+  LogEntry* TryState(InstanceId instance);
+  void Persist(InstanceId instance, const LogEntry& state);
+
+  ProposalNumber Promise(const LogEntry& state) const;
+
+  bool IsCompacted(InstanceId instance) const {
+    return instance <= compacted_;
+  }
+
+  // Lease held by another proposer
+  bool Fenced(const ProposalNumber& n);
+  void GrantLease(const ProposalNumber& n);
+
+  // Mark votes cast for n in instances <= committed as chosen
+  void Commit(const ProposalNumber& n, InstanceId committed,
+              ChosenList& chosen);
+
+  // Without mutex
+  void Notify(ChosenList chosen);
+
+ private:
+  Log& log_;
+  ChosenCallback on_chosen_;
+  AcceptedCallback on_accepted_;
+
+  const bool leases_;
+  // paxos.lease
+  const whirl::Jiffies lease_;
+
+  whirl::node::store::KVStore<Meta> meta_store_;
+
+  await::fibers::Mutex mutex_;
+  InstanceStore<LogEntry> states_;
+  Meta meta_;
+
+  // Instances <= chosen_prefix_ are chosen
+  InstanceId chosen_prefix_ = 0;
+  // Instances <= compacted_ are dropped
+  InstanceId compacted_ = 0;
+  InstanceId committed_hint_ = 0;
+
+  std::string lease_holder_;
+  // Local monotonic time
+  uint64_t lease_until_ = 0;
+
+  timber::Logger logger_;
+};
+
+}  // namespace paxos
+
+}  // namespace rsm
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <whirl/node/time/jiffies.hpp>
+
+#include <cstdint>
+
+namespace rsm {
+
+namespace paxos {
+
+// Randomized exponential backoff between proposal attempts
+//
+// Delay grows as init * factor^attempt up to max, actual sleep is
+// uniformly distributed in [delay / 2, delay]: jitter breaks
+// the symmetry between duelling proposers
+
+class Backoff {
+ public:
+  struct Params {
+    uint64_t init;
+    uint64_t max;
+    uint64_t factor;
+
+    // paxos.backoff.{init, max, factor}
+    static Params FromConfig();
+  };
+
+  explicit Backoff(Params params);
+
+  // Jittered delay for the next attempt
+  whirl::Jiffies Next();
+
+  void Reset();
+
+ private:
+  const Params params_;
+  uint64_t delay_;
+};
+
+}  // namespace paxos
+
+}  // namespace rsm
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <rsm/replica/paxos/proposal.hpp>
+
+#include <wheels/support/panic.hpp>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace rsm {
+
+namespace paxos {
+
+// Per-instance state for many concurrent instances
+//
+// Active instances [base, base + window) live in a dense ring buffer
+// indexed by instance % window, so lookups on the hot path do not
+// allocate or hash. Touching an instance beyond the window slides
+// the window forward, instances left behind spill into an ordered map.
+//
+// Invariant: spilled instances < base
+//
+// NOT thread safe, external synchronization required
+
+template <typename State>
+class InstanceStore {
+ public:
+  explicit InstanceStore(size_t window) : slots_(window) {
+    if (window == 0) {
+      WHEELS_PANIC("Empty instance window");
+    }
+  }
+
+  State* Find(InstanceId instance) {
+    if (InWindow(instance)) {
+      auto& slot = Slot(instance);
+      return slot.has_value() ? &*slot : nullptr;
+    }
+    if (auto it = spill_.find(instance); it != spill_.end()) {
+      return &it->second;
+    }
+    return nullptr;
+  }
+
+  const State* Find(InstanceId instance) const {
+    return const_cast<InstanceStore*>(this)->Find(instance);
+  }
+
+  bool Has(InstanceId instance) const {
+    return Find(instance) != nullptr;
+  }
+
+  State& Put(InstanceId instance, State state) {
+    if (instance < base_) {
+      auto [it, inserted] = spill_.insert_or_assign(instance, std::move(state));
+      if (inserted) {
+        ++size_;
+      }
+      return it->second;
+    }
+
+    if (instance >= base_ + Window()) {
+      Slide(instance + 1 - Window());
+    }
+
+    auto& slot = Slot(instance);
+    if (!slot.has_value()) {
+      ++size_;
+    }
+    slot = std::move(state);
+    return *slot;
+  }
+
+  void Erase(InstanceId instance) {
+    if (InWindow(instance)) {
+      auto& slot = Slot(instance);
+      if (slot.has_value()) {
+        slot.reset();
+        --size_;
+      }
+    } else {
+      size_ -= spill_.erase(instance);
+    }
+  }
+
+  // Drop state of all instances < end
+  void Forget(InstanceId end) {
+    auto spill_end = spill_.lower_bound(end);
+    size_ -= std::distance(spill_.begin(), spill_end);
+    spill_.erase(spill_.begin(), spill_end);
+
+    if (end > base_) {
+      InstanceId window_end = std::min(end, base_ + Window());
+      for (InstanceId instance = base_; instance < window_end; ++instance) {
+        Erase(instance);
+      }
+      // Freed slots are exactly the ones for [base_ + window, end + window)
+      base_ = end;
+    }
+  }
+
+  // Number of stored instances
+  size_t Size() const {
+    return size_;
+  }
+
+  size_t SpillSize() const {
+    return spill_.size();
+  }
+
+ private:
+  size_t Window() const {
+    return slots_.size();
+  }
+
+  bool InWindow(InstanceId instance) const {
+    return instance >= base_ && instance < base_ + Window();
+  }
+
+  std::optional<State>& Slot(InstanceId instance) {
+    return slots_[instance % Window()];
+  }
+
+  void Slide(InstanceId new_base) {
+    InstanceId evict_end = std::min(new_base, base_ + Window());
+    for (InstanceId instance = base_; instance < evict_end; ++instance) {
+      auto& slot = Slot(instance);
+      if (slot.has_value()) {
+        spill_.emplace(instance, std::move(*slot));
+        slot.reset();
+      }
+    }
+    base_ = new_base;
+  }
+
+ private:
+  // Ring buffer for the active window
+  std::vector<std::optional<State>> slots_;
+  InstanceId base_ = 0;
+
+  // Old instances
+  std::map<InstanceId, State> spill_;
+
+  size_t size_ = 0;
+};
+
+}  // namespace paxos
+
+}  // namespace rsm
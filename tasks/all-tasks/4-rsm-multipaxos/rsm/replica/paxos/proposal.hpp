@@ -0,0 +1,79 @@
+#pragma once
+
+#include <rsm/replica/batch.hpp>
+
+#include <muesli/serializable.hpp>
+
+// Enable string serialization
+#include <cereal/types/string.hpp>
+
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <tuple>
+
+namespace rsm {
+
+namespace paxos {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Independent Single-Decree Paxos instances (log slots) are numbered from 1
+using InstanceId = uint64_t;
+
+// Value decided in a single instance
+using Value = Batch;
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Proposal number = (round, node)
+// Node id breaks ties between proposers running the same round,
+// so distinct proposers never share a proposal number
+
+struct ProposalNumber {
+  uint64_t round = 0;
+  std::string node;
+
+  static ProposalNumber Zero() {
+    return {0, ""};
+  }
+
+  bool operator<(const ProposalNumber& that) const {
+    return std::tie(round, node) < std::tie(that.round, that.node);
+  }
+
+  bool operator==(const ProposalNumber& that) const {
+    return round == that.round && node == that.node;
+  }
+
+  bool operator!=(const ProposalNumber& that) const {
+    return !(*this == that);
+  }
+
+  MUESLI_SERIALIZABLE(round, node)
+};
+
+inline std::ostream& operator<<(std::ostream& out, const ProposalNumber& n) {
+  out << "{" << n.round << ", " << n.node << "}";
+  return out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Proposal = Proposal number + Value
+
+struct Proposal {
+  ProposalNumber n;
+  Value value;
+
+  MUESLI_SERIALIZABLE(n, value)
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Proposal& proposal) {
+  out << "{" << proposal.n << ", " << proposal.value << "}";
+  return out;
+}
+
+}  // namespace paxos
+
+}  // namespace rsm
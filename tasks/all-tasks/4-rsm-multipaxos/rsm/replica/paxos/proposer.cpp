@@ -0,0 +1,231 @@
+#include <rsm/replica/paxos/proposer.hpp>
+#include <rsm/replica/paxos/backoff.hpp>
+
+#include <whirl/node/runtime/shortcuts.hpp>
+
+#include <commute/rpc/call.hpp>
+
+#include <await/fibers/core/await.hpp>
+#include <await/fibers/sync/future.hpp>
+
+#include <timber/log.hpp>
+
+#include <algorithm>
+
+using namespace whirl;
+
+namespace rsm {
+
+namespace paxos {
+
+static const std::string kRoundKey = "round";
+
+Proposer::Proposer()
+    : Peer(node::rt::Config()),
+      store_(node::rt::Database(), "proposer"),
+      logger_("Paxos.Proposer", node::rt::LoggerBackend()) {
+  max_round_ = store_.GetOr(kRoundKey, 0);
+}
+
+Value Proposer::Propose(InstanceId instance, Value input) {
+  Backoff backoff{Backoff::Params::FromConfig()};
+
+  while (true) {
+    if (auto chosen = TryPropose(instance, input)) {
+      return std::move(*chosen);
+    }
+
+    // Give the competing proposer a chance to complete
+    auto delay = backoff.Next();
+    LOG_INFO("Retry instance {} after {} jiffies", instance, delay.Count());
+    node::rt::SleepFor(delay);
+  }
+}
+
+std::optional<Value> Proposer::TryPropose(InstanceId instance, Value input) {
+  auto n = NextProposalNumber();
+
+  // Phase 1
+
+  auto promises = RunPrepare(instance, n);
+
+  if (!promises.ok) {
+    AdoptAdvice(promises.advice);
+    LOG_INFO("Prepare {} in instance {} failed", n, instance);
+    return std::nullopt;
+  }
+
+  Proposal proposal{n, ChooseValue(promises.acks, std::move(input))};
+
+  // Phase 2
+
+  auto accepted = RunAccept(instance, proposal, /*committed=*/0);
+
+  if (!accepted.ok) {
+    AdoptAdvice(accepted.advice);
+    LOG_INFO("Accept {} in instance {} failed", n, instance);
+    return std::nullopt;
+  }
+
+  LOG_INFO("Chosen in instance {}: {}", instance, proposal);
+  return std::move(proposal.value);
+}
+
+auto Proposer::Lead(InstanceId from, Jiffies timeout)
+    -> std::optional<Leadership> {
+  auto n = NextProposalNumber();
+
+  std::vector<await::futures::Future<proto::MultiPrepare::Response>> promises;
+
+  for (const auto& peer : ListPeers().WithMe()) {
+    promises.push_back(  //
+        commute::rpc::Call("Acceptor.MultiPrepare")
+            .Args(proto::MultiPrepare::Request{from, n})
+            .Via(Channel(peer))
+            .Context(await::context::ThisFiber())
+            .AtLeastOnce()
+            .Start()
+            .As<proto::MultiPrepare::Response>());
+  }
+
+  auto quorum = PhaseQuorum<proto::MultiPrepare>(std::move(promises),
+                                                 Majority(NodeCount()));
+  auto outcome =
+      await::fibers::Await(WithTimeout(std::move(quorum), timeout))
+          .ValueOrThrow();
+
+  if (!outcome.ok) {
+    AdoptAdvice(outcome.advice);
+    return std::nullopt;
+  }
+
+  Leadership leadership{n, {}, 0};
+
+  for (const auto& promise : outcome.acks) {
+    leadership.compacted = std::max(leadership.compacted, promise.compacted);
+    for (const auto& vote : promise.votes) {
+      auto it = leadership.votes.find(vote.instance);
+      if (it == leadership.votes.end() || it->second.n < vote.proposal.n) {
+        leadership.votes.insert_or_assign(vote.instance, vote.proposal);
+      }
+    }
+  }
+
+  LOG_INFO("Prepared {} for instances >= {}, votes: {}", n, from,
+           leadership.votes.size());
+
+  return leadership;
+}
+
+bool Proposer::Accept(InstanceId instance, const Proposal& proposal,
+                      InstanceId committed) {
+  auto accepted = RunAccept(instance, proposal, committed);
+  if (!accepted.ok) {
+    AdoptAdvice(accepted.advice);
+  }
+  return accepted.ok;
+}
+
+bool Proposer::Heartbeat(const ProposalNumber& n, InstanceId committed,
+                         Jiffies timeout) {
+  std::vector<await::futures::Future<proto::Heartbeat::Response>> acks;
+
+  for (const auto& peer : ListPeers().WithMe()) {
+    acks.push_back(  //
+        commute::rpc::Call("Acceptor.Heartbeat")
+            .Args(proto::Heartbeat::Request{n, committed})
+            .Via(Channel(peer))
+            .Context(await::context::ThisFiber())
+            .AtMostOnce()
+            .Start()
+            .As<proto::Heartbeat::Response>());
+  }
+
+  auto quorum =
+      PhaseQuorum<proto::Heartbeat>(std::move(acks), Majority(NodeCount()));
+  auto outcome =
+      await::fibers::Await(WithTimeout(std::move(quorum), timeout))
+          .ValueOrThrow();
+
+  if (!outcome.ok) {
+    AdoptAdvice(outcome.advice);
+  }
+  return outcome.ok;
+}
+
+QuorumOutcome<proto::Prepare> Proposer::RunPrepare(InstanceId instance,
+                                                   const ProposalNumber& n) {
+  std::vector<await::futures::Future<proto::Prepare::Response>> promises;
+
+  for (const auto& peer : ListPeers().WithMe()) {
+    promises.push_back(  //
+        commute::rpc::Call("Acceptor.Prepare")
+            .Args(proto::Prepare::Request{instance, n})
+            .Via(Channel(peer))
+            .Context(await::context::ThisFiber())
+            .AtLeastOnce()
+            .Start()
+            .As<proto::Prepare::Response>());
+  }
+
+  return await::fibers::Await(
+             PhaseQuorum<proto::Prepare>(std::move(promises),
+                                         Majority(NodeCount())))
+      .ValueOrThrow();
+}
+
+QuorumOutcome<proto::Accept> Proposer::RunAccept(InstanceId instance,
+                                                 const Proposal& proposal,
+                                                 InstanceId committed) {
+  std::vector<await::futures::Future<proto::Accept::Response>> votes;
+
+  for (const auto& peer : ListPeers().WithMe()) {
+    votes.push_back(  //
+        commute::rpc::Call("Acceptor.Accept")
+            .Args(proto::Accept::Request{instance, proposal, committed})
+            .Via(Channel(peer))
+            .Context(await::context::ThisFiber())
+            .AtLeastOnce()
+            .Start()
+            .As<proto::Accept::Response>());
+  }
+
+  return await::fibers::Await(
+             PhaseQuorum<proto::Accept>(std::move(votes),
+                                        Majority(NodeCount())))
+      .ValueOrThrow();
+}
+
+Value Proposer::ChooseValue(
+    const std::vector<proto::Prepare::Response>& promises, Value input) {
+  std::optional<Proposal> latest;
+
+  for (const auto& promise : promises) {
+    if (promise.vote.has_value() &&
+        (!latest.has_value() || latest->n < promise.vote->n)) {
+      latest = promise.vote;
+    }
+  }
+
+  if (!latest.has_value()) {
+    return input;
+  }
+  return latest->value;
+}
+
+ProposalNumber Proposer::NextProposalNumber() {
+  auto guard = mutex_.Guard();
+  ++max_round_;
+  store_.Put(kRoundKey, max_round_);
+  return {max_round_, node::rt::HostName()};
+}
+
+void Proposer::AdoptAdvice(const ProposalNumber& advice) {
+  auto guard = mutex_.Guard();
+  // Persisted with the next proposal number
+  max_round_ = std::max(max_round_, advice.round);
+}
+
+}  // namespace paxos
+
+}  // namespace rsm
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <rsm/replica/paxos/proposal.hpp>
+#include <rsm/replica/paxos/proto.hpp>
+#include <rsm/replica/paxos/quorum.hpp>
+
+#include <whirl/node/cluster/peer.hpp>
+#include <whirl/node/store/kv.hpp>
+
+#include <await/fibers/sync/mutex.hpp>
+
+#include <timber/logger.hpp>
+
+#include <map>
+#include <optional>
+#include <vector>
+
+namespace rsm {
+
+namespace paxos {
+
+// Proposer role for all instances on this node
+//
+// Thread-safe, instances are decided independently and concurrently
+
+class Proposer : public whirl::node::cluster::Peer {
+ public:
+  Proposer();
+
+  // Runs Single-Decree Paxos in `instance` until some value is chosen
+  // Returns chosen value, not necessarily `input`
+  Value Propose(InstanceId instance, Value input);
+
+  // Single round of Propose, std::nullopt if it fails
+  // (competing proposer, compacted instance)
+  std::optional<Value> TryPropose(InstanceId instance, Value input);
+
+  // Stable leader
+
+  // Result of Phase 1 for all instances >= from
+  struct Leadership {
+    ProposalNumber n;
+    // Instance -> highest-numbered vote reported by the quorum
+    std::map<InstanceId, Proposal> votes;
+    // Instances <= compacted are chosen, but their votes are dropped
+    // by some acceptors in the quorum
+    InstanceId compacted;
+  };
+
+  // One Phase 1 for all instances >= from,
+  // fails if the quorum is not reached in `timeout`
+  std::optional<Leadership> Lead(InstanceId from, whirl::Jiffies timeout);
+
+  // Phase 2 only, proposal.n should be prepared with Lead
+  // Piggybacks leader commit index
+  bool Accept(InstanceId instance, const Proposal& proposal,
+              InstanceId committed);
+
+  // Renews leader lease on the quorum and propagates commit index
+  bool Heartbeat(const ProposalNumber& n, InstanceId committed,
+                 whirl::Jiffies timeout);
+
+ private:
+  // Phases
+
+  QuorumOutcome<proto::Prepare> RunPrepare(InstanceId instance,
+                                           const ProposalNumber& n);
+  QuorumOutcome<proto::Accept> RunAccept(InstanceId instance,
+                                         const Proposal& proposal,
+                                         InstanceId committed);
+
+  // Value of the highest-numbered vote or our own input
+  Value ChooseValue(const std::vector<proto::Prepare::Response>& promises,
+                    Value input);
+
+  // Proposal numbers
+
+  // Fresh number, greater than any number observed on this node
+  ProposalNumber NextProposalNumber();
+  // Jump ahead of the number reported by acceptors
+  void AdoptAdvice(const ProposalNumber& advice);
+
+ private:
+  // Shared by all instances
+  // Persistent: proposal numbers are never reused after restart
+  whirl::node::store::KVStore<uint64_t> store_;
+  await::fibers::Mutex mutex_;
+  uint64_t max_round_;
+
+  timber::Logger logger_;
+};
+
+}  // namespace paxos
+
+}  // namespace rsm
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <rsm/replica/paxos/proposal.hpp>
+
+#include <muesli/serializable.hpp>
+
+#include <cereal/types/optional.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace rsm {
+
+namespace paxos::proto {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Prepare / Accept are addressed to a single instance,
+// MultiPrepare covers all instances >= from at once
+//
+// Acceptor rejects requests to compacted instances (see Acceptor::Compact)
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Phase I
+
+struct Prepare {
+  // Prepare
+  struct Request {
+    InstanceId instance;
+    ProposalNumber n;
+
+    MUESLI_SERIALIZABLE(instance, n)
+  };
+
+  // Promise
+  struct Response {
+    bool ack = false;
+    ProposalNumber advice;
+    std::optional<Proposal> vote;
+
+    MUESLI_SERIALIZABLE(ack, advice, vote)
+  };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Phase II
+
+struct Accept {
+  // Accept
+  struct Request {
+    InstanceId instance;
+    Proposal proposal;
+    // Instances <= committed are chosen on the leader,
+    // see Heartbeat
+    InstanceId committed = 0;
+
+    MUESLI_SERIALIZABLE(instance, proposal, committed)
+  };
+
+  // Accepted
+  struct Response {
+    bool ack = false;
+    ProposalNumber advice;
+
+    MUESLI_SERIALIZABLE(ack, advice)
+  };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Stable leader
+
+// Phase I for all instances >= from
+// Acceptor promises n for every instance and grants leader lease to n.node
+
+struct MultiPrepare {
+  struct Request {
+    InstanceId from;
+    ProposalNumber n;
+
+    MUESLI_SERIALIZABLE(from, n)
+  };
+
+  struct Vote {
+    InstanceId instance;
+    Proposal proposal;
+
+    MUESLI_SERIALIZABLE(instance, proposal)
+  };
+
+  struct Response {
+    bool ack = false;
+    ProposalNumber advice;
+    // Votes in instances >= from
+    std::vector<Vote> votes;
+    // Instances <= compacted are chosen and replaced with a snapshot
+    InstanceId compacted = 0;
+
+    MUESLI_SERIALIZABLE(ack, advice, votes, compacted)
+  };
+};
+
+// Renews leader lease
+//
+// Instances <= committed are chosen on the leader: acceptor vote in such
+// instance is chosen if it was cast for the leader's own proposal number
+
+struct Heartbeat {
+  struct Request {
+    ProposalNumber n;
+    InstanceId committed;
+
+    MUESLI_SERIALIZABLE(n, committed)
+  };
+
+  struct Response {
+    bool ack = false;
+    ProposalNumber advice;
+
+    MUESLI_SERIALIZABLE(ack, advice)
+  };
+};
+
+}  // namespace paxos::proto
+
+}  // namespace rsm
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <rsm/replica/paxos/proposal.hpp>
+
+#include <whirl/node/runtime/shortcuts.hpp>
+
+#include <await/fibers/core/api.hpp>
+#include <await/futures/core/future.hpp>
+
+#include <wheels/result.hpp>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace rsm {
+
+namespace paxos {
+
+////////////////////////////////////////////////////////////////////////////////
+
+inline size_t Majority(size_t nodes) {
+  return nodes / 2 + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Outcome of a single phase of Paxos
+
+template <typename Phase>
+struct QuorumOutcome {
+  // Quorum of acceptors acknowledged the request
+  bool ok = false;
+  // Positive responses
+  std::vector<typename Phase::Response> acks;
+  // Max proposal number reported by rejecting acceptors
+  ProposalNumber advice = ProposalNumber::Zero();
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+template <typename Phase>
+class QuorumCollector {
+  using Response = typename Phase::Response;
+  using Outcome = QuorumOutcome<Phase>;
+
+ public:
+  QuorumCollector(size_t total, size_t threshold,
+                  await::futures::Promise<Outcome> promise)
+      : total_(total), threshold_(threshold), promise_(std::move(promise)) {
+  }
+
+  void Add(wheels::Result<Response> response) {
+    std::unique_lock lock(mutex_);
+
+    if (!promise_.has_value()) {
+      return;  // Already completed
+    }
+
+    if (response.IsOk() && response->ack) {
+      outcome_.acks.push_back(std::move(*response));
+      if (outcome_.acks.size() == threshold_) {
+        outcome_.ok = true;
+        Complete(lock);
+      }
+    } else {
+      if (response.IsOk() && outcome_.advice < response->advice) {
+        outcome_.advice = response->advice;
+      }
+      // Quorum is no longer reachable
+      if (++failures_ > total_ - threshold_) {
+        Complete(lock);
+      }
+    }
+  }
+
+ private:
+  void Complete(std::unique_lock<std::mutex>& lock) {
+    auto promise = std::move(*promise_);
+    promise_.reset();
+    auto outcome = std::move(outcome_);
+    lock.unlock();
+
+    std::move(promise).SetValue(std::move(outcome));
+  }
+
+ private:
+  const size_t total_;
+  const size_t threshold_;
+
+  std::mutex mutex_;
+  size_t failures_ = 0;
+  Outcome outcome_;
+  std::optional<await::futures::Promise<Outcome>> promise_;
+};
+
+}  // namespace detail
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Quorum combinator, parameterized by phase (proto::Prepare, proto::Accept)
+//
+// Completes as soon as `threshold` acceptors acknowledged the request
+// (outcome.ok = true) or so many of them rejected the request or failed
+// that the quorum is no longer reachable (outcome.ok = false).
+// Hangs while neither is known (e.g. partition)
+
+template <typename Phase>
+await::futures::Future<QuorumOutcome<Phase>> PhaseQuorum(
+    std::vector<await::futures::Future<typename Phase::Response>> responses,
+    size_t threshold) {
+  auto [future, promise] = await::futures::MakeContract<QuorumOutcome<Phase>>();
+
+  if (threshold == 0 || threshold > responses.size()) {
+    QuorumOutcome<Phase> outcome;
+    outcome.ok = (threshold == 0);
+    std::move(promise).SetValue(std::move(outcome));
+    return std::move(future);
+  }
+
+  auto collector = std::make_shared<detail::QuorumCollector<Phase>>(
+      responses.size(), threshold, std::move(promise));
+
+  for (auto& response : responses) {
+    std::move(response).Subscribe(
+        [collector](wheels::Result<typename Phase::Response> result) {
+          collector->Add(std::move(result));
+        });
+  }
+
+  return std::move(future);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Fails the phase (outcome.ok = false) if it is not completed in time,
+// e.g. when acceptors required for the quorum are down
+
+template <typename Phase>
+await::futures::Future<QuorumOutcome<Phase>> WithTimeout(
+    await::futures::Future<QuorumOutcome<Phase>> phase,
+    whirl::Jiffies timeout) {
+  using Outcome = QuorumOutcome<Phase>;
+
+  struct State {
+    std::mutex mutex;
+    std::optional<await::futures::Promise<Outcome>> promise;
+
+    void Complete(Outcome outcome) {
+      std::unique_lock lock(mutex);
+      if (!promise.has_value()) {
+        return;
+      }
+      auto first = std::move(*promise);
+      promise.reset();
+      lock.unlock();
+
+      std::move(first).SetValue(std::move(outcome));
+    }
+  };
+
+  auto [future, promise] = await::futures::MakeContract<Outcome>();
+
+  auto state = std::make_shared<State>();
+  state->promise.emplace(std::move(promise));
+
+  std::move(phase).Subscribe([state](wheels::Result<Outcome> outcome) {
+    state->Complete(outcome.IsOk() ? std::move(*outcome) : Outcome{});
+  });
+
+  await::fibers::Go([state, timeout]() {
+    whirl::node::rt::SleepFor(timeout);
+    state->Complete(Outcome{});
+  });
+
+  return std::move(future);
+}
+
+}  // namespace paxos
+
+}  // namespace rsm
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <rsm/replica/paxos/proposal.hpp>
+#include <rsm/replica/store/snapshot.hpp>
+
+#include <muesli/empty.hpp>
+#include <muesli/serializable.hpp>
+
+#include <cereal/types/optional.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace rsm {
+
+namespace proto {
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Catch-up for lagging replicas
+//
+// Chosen slots are streamed in chunks: requester asks for the next chunk
+// once the previous one arrived, so at most one chunk per stream
+// is in flight
+
+struct Fetch {
+  struct Request {
+    // First slot not applied by the requester
+    paxos::InstanceId from;
+    // Chunk budget, command payload bytes
+    size_t max_bytes;
+
+    MUESLI_SERIALIZABLE(from, max_bytes)
+  };
+
+  struct Decision {
+    paxos::InstanceId slot;
+    paxos::Value value;
+
+    MUESLI_SERIALIZABLE(slot, value)
+  };
+
+  struct Response {
+    // Set if `from` is already compacted on the responder
+    std::optional<Snapshot> snapshot;
+    // Consecutive chosen slots following `from` / snapshot
+    std::vector<Decision> decisions;
+    // Chunk was cut by the budget, more chosen slots may follow
+    bool more = false;
+
+    MUESLI_SERIALIZABLE(snapshot, decisions, more)
+  };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Mencius: owner announces decisions in its slots
+
+struct Announce {
+  struct Request {
+    // Owner ballot
+    paxos::ProposalNumber n;
+    // Owner slots in [skip_from, skip_to) are no-ops
+    paxos::InstanceId skip_from = 0;
+    paxos::InstanceId skip_to = 0;
+    // Votes for n in these slots are chosen
+    std::vector<paxos::InstanceId> chosen;
+
+    MUESLI_SERIALIZABLE(n, skip_from, skip_to, chosen)
+  };
+
+  using Response = muesli::EmptyMessage;
+};
+
+}  // namespace proto
+
+}  // namespace rsm
@@ -37,6 +37,17 @@ using NotALeader = muesli::EmptyMessage;
 
 //////////////////////////////////////////////////////////////////////
 
-using Response = std::variant<Ack, RedirectToLeader, NotALeader>;
+// Client session is evicted, the command is not applied
+
+struct SessionExpired {
+  std::string client_id;
+
+  MUESLI_SERIALIZABLE(client_id);
+};
+
+//////////////////////////////////////////////////////////////////////
+
+using Response =
+    std::variant<Ack, RedirectToLeader, NotALeader, SessionExpired>;
 
 }  // namespace rsm
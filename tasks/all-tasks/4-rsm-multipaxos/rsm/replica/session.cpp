@@ -0,0 +1,99 @@
+#include <rsm/replica/session.hpp>
+
+#include <wheels/support/panic.hpp>
+
+namespace rsm {
+
+SessionTable::SessionTable(size_t capacity) : capacity_(capacity) {
+}
+
+std::string SessionTable::MakeSessionId(const Command& command,
+                                        uint64_t slot, size_t index) {
+  return command.request_id.client_id + "/" + std::to_string(slot) + "." +
+         std::to_string(index);
+}
+
+std::string SessionTable::ClientOf(const std::string& client_id) {
+  return client_id.substr(0, client_id.rfind('/'));
+}
+
+void SessionTable::Open(const std::string& client_id) {
+  if (index_.count(client_id) > 0) {
+    return;
+  }
+
+  if (capacity_ > 0 && index_.size() == capacity_) {
+    index_.erase(sessions_.back().client_id);
+    sessions_.pop_back();
+  }
+  sessions_.push_front({client_id, 0, std::nullopt});
+  index_.emplace(client_id, sessions_.begin());
+}
+
+bool SessionTable::Has(const std::string& client_id) const {
+  return index_.count(client_id) > 0;
+}
+
+void SessionTable::Acknowledge(const Command& command) {
+  auto* session = Find(command.request_id.client_id);
+  if (session != nullptr && session->index <= command.acked) {
+    session->response.reset();
+  }
+}
+
+std::optional<muesli::Bytes> SessionTable::Lookup(const RequestId& id) {
+  auto it = index_.find(id.client_id);
+  if (it == index_.end() || id.index > it->second->index) {
+    return std::nullopt;  // New request
+  }
+
+  Touch(it->second);
+
+  const auto& session = *it->second;
+  if (id.index == session.index && session.response.has_value()) {
+    return session.response;
+  }
+  // Response is already received by the client
+  return muesli::Bytes{};
+}
+
+void SessionTable::Record(const RequestId& id, muesli::Bytes response) {
+  auto it = index_.find(id.client_id);
+  if (it == index_.end()) {
+    WHEELS_PANIC("Session of client " << id.client_id << " is not open");
+  }
+
+  Touch(it->second);
+
+  auto& session = *it->second;
+  session.index = id.index;
+  session.response = std::move(response);
+}
+
+void SessionTable::Clear() {
+  sessions_.clear();
+  index_.clear();
+}
+
+auto SessionTable::MakeSnapshot() const -> Snapshot {
+  return {sessions_.begin(), sessions_.end()};
+}
+
+void SessionTable::Install(const Snapshot& snapshot) {
+  Clear();
+  for (const auto& session : snapshot) {
+    sessions_.push_back(session);
+    index_.emplace(session.client_id, std::prev(sessions_.end()));
+  }
+}
+
+SessionTable::Session* SessionTable::Find(const std::string& client_id) {
+  auto it = index_.find(client_id);
+  return it != index_.end() ? &*it->second : nullptr;
+}
+
+void SessionTable::Touch(SessionList::iterator session) {
+  sessions_.splice(sessions_.begin(), sessions_, session);
+}
+
+}  // namespace rsm
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <rsm/client/command.hpp>
+#include <rsm/client/request_id.hpp>
+
+#include <muesli/bytes.hpp>
+#include <muesli/serializable.hpp>
+
+#include <cereal/types/optional.hpp>
+#include <cereal/types/string.hpp>
+
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rsm {
+
+// Exactly-once: last applied request of each client and its response
+//
+// A client opens its session with a separate command (see
+// Command::OpensSession) and uses the id assigned by the replicas.
+// Clients are single-threaded and synchronous, so a client session holds
+// at most one response. The response is dropped as soon as the client
+// acknowledges it (Command::acked)
+//
+// At most `capacity` sessions (0 = unbounded), the least recently active
+// one is evicted first. Requests of an evicted client are not applied,
+// the client gets SessionExpired: a retry never applies a command twice.
+// Session ids are never reused, so a reopened session cannot be mistaken
+// for an evicted one
+//
+// Part of the replica snapshot
+//
+// NOT thread-safe, external synchronization required
+
+class SessionTable {
+ public:
+  struct Session {
+    std::string client_id;
+    // Last applied request
+    uint64_t index = 0;
+    // Not yet acknowledged by the client
+    std::optional<muesli::Bytes> response;
+
+    MUESLI_SERIALIZABLE(client_id, index, response)
+  };
+
+  // Most recently active first
+  using Snapshot = std::vector<Session>;
+
+ public:
+  explicit SessionTable(size_t capacity);
+
+  // Id of the session opened by `command` at the given log position:
+  // "<client guid>/<slot>.<index in batch>"
+  static std::string MakeSessionId(const Command& command, uint64_t slot,
+                                   size_t index);
+  // Client guid of the session / session-opening command
+  static std::string ClientOf(const std::string& client_id);
+
+  // Session ids must be unique
+  void Open(const std::string& client_id);
+
+  // false if the session is evicted or was never opened
+  bool Has(const std::string& client_id) const;
+
+  // Drop responses for requests <= command.acked
+  void Acknowledge(const Command& command);
+
+  // Response for already applied request, empty if the client has
+  // already received it, std::nullopt for a new request
+  // Session should be open
+  std::optional<muesli::Bytes> Lookup(const RequestId& id);
+
+  // Session should be open
+  void Record(const RequestId& id, muesli::Bytes response);
+
+  void Clear();
+
+  Snapshot MakeSnapshot() const;
+  void Install(const Snapshot& snapshot);
+
+  size_t Size() const {
+    return index_.size();
+  }
+
+ private:
+  using SessionList = std::list<Session>;
+
+  // nullptr if missing
+  Session* Find(const std::string& client_id);
+  // Mark session as most recently active
+  void Touch(SessionList::iterator session);
+
+ private:
+  const size_t capacity_;
+
+  // Most recently active first
+  SessionList sessions_;
+  std::unordered_map<std::string, SessionList::iterator> index_;
+};
+
+}  // namespace rsm
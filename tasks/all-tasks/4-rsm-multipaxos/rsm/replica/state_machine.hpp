@@ -4,12 +4,15 @@
 
 #include <muesli/bytes.hpp>
 
-#include <string>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace rsm {
 
 // NOT thread-safe!
+// Exception: Apply of commands with disjoint footprints, see Footprint
 
 struct IStateMachine {
   virtual ~IStateMachine() = default;
@@ -25,6 +28,16 @@ struct IStateMachine {
 
   virtual muesli::Bytes MakeSnapshot() = 0;
   virtual void InstallSnapshot(const muesli::Bytes& snapshot) = 0;
+
+  // Parallel apply
+
+  // Keys read or written by command
+  // Commands with disjoint footprints commute and may be applied concurrently
+  // std::nullopt = conflicts with any command
+  virtual std::optional<std::vector<std::string>> Footprint(
+      const Command& /*command*/) {
+    return std::nullopt;
+  }
 };
 
 using IStateMachinePtr = std::shared_ptr<IStateMachine>;
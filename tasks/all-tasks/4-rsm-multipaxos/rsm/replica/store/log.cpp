@@ -7,6 +7,8 @@
 
 #include <whirl/node/runtime/shortcuts.hpp>
 
+#include <wheels/support/panic.hpp>
+
 namespace rsm {
 
 Log::Log(const persist::fs::Path& store_dir) : impl_(MakeLogImpl(store_dir)) {
@@ -40,8 +42,19 @@ std::shared_ptr<Log::ILogImpl> Log::MakeLogImpl(
     const persist::fs::Path& store_dir) {
   const auto log_path = store_dir / "log";
 
-  return std::make_shared<persist::rsm::multipaxos::FileLog>(
-      whirl::node::rt::Fs(), log_path);
+  // rsm.store.log = file | segmented
+  const auto backend = whirl::node::rt::Config()->GetString("rsm.store.log");
+
+  if (backend == "segmented") {
+    // Prefix truncation drops whole segments
+    return std::make_shared<persist::rsm::multipaxos::SegmentedLog>(
+        whirl::node::rt::Fs(), log_path);
+  } else if (backend == "file") {
+    return std::make_shared<persist::rsm::multipaxos::FileLog>(
+        whirl::node::rt::Fs(), log_path);
+  }
+
+  WHEELS_PANIC("Unknown log backend: " << backend);
 }
 
 }  // namespace rsm
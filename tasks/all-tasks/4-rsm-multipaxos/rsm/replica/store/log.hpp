@@ -12,6 +12,7 @@ namespace rsm {
 
 // Persistent log
 // Indexed from 1
+// Backend is selected by rsm.store.log
 // NOT thread safe, external synchronization required
 
 class Log {
@@ -1,21 +1,31 @@
 #pragma once
 
-#include <rsm/client/command.hpp>
+#include <rsm/replica/paxos/proposal.hpp>
 
 #include <muesli/serializable.hpp>
 
+#include <cereal/types/optional.hpp>
+
+#include <optional>
+
 namespace rsm {
 
+// Log entry = durable acceptor state of the corresponding Paxos instance
+
 struct LogEntry {
-  // Acceptor state?
-  uint64_t ___;
+  // Do not accept proposals with numbers < promise
+  paxos::ProposalNumber promise;
+  // Last accepted proposal
+  std::optional<paxos::Proposal> vote;
+  // Vote is known to be chosen
+  bool chosen = false;
 
   // Make empty log entry
   static LogEntry Empty() {
     return {};
   }
 
-  MUESLI_SERIALIZABLE(___)
+  MUESLI_SERIALIZABLE(promise, vote, chosen)
 };
 
 }  // namespace rsm
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <rsm/replica/paxos/proposal.hpp>
+#include <rsm/replica/session.hpp>
+
+#include <muesli/bytes.hpp>
+#include <muesli/serializable.hpp>
+
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+namespace rsm {
+
+// Replaces compacted log prefix [1, index]
+
+struct Snapshot {
+  // Last slot applied to the state machine, 0 = no snapshot
+  paxos::InstanceId index = 0;
+  // IStateMachine::MakeSnapshot
+  muesli::Bytes state;
+  // Exactly-once
+  SessionTable::Snapshot sessions;
+
+  MUESLI_SERIALIZABLE(index, state, sessions)
+};
+
+}  // namespace rsm
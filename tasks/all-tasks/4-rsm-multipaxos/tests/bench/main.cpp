@@ -0,0 +1,237 @@
+#include <kv/client.hpp>
+#include <kv/main.hpp>
+#include <rsm/proxy/main.hpp>
+
+// Node
+#include <whirl/node/runtime/shortcuts.hpp>
+
+// Logging
+#include <timber/log.hpp>
+
+// Concurrency
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/sync/future.hpp>
+
+// Simulation
+#include <matrix/facade/world.hpp>
+#include <matrix/world/global/vars.hpp>
+#include <matrix/world/global/time.hpp>
+#include <matrix/client/rpc.hpp>
+#include <matrix/test/main.hpp>
+#include <matrix/test/runner.hpp>
+
+#include <commute/rpc/id.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <tests/time_models/async.hpp>
+
+using namespace whirl;
+
+//////////////////////////////////////////////////////////////////////
+
+// Write throughput of the stable leader vs in-flight Phase 2 window
+// and batch size, and of the stable leader vs rotating slot owners
+// (Mencius) vs replica count, and of the stable leader vs leaderless
+// replicas (EPaxos) under low and high key contention, fault-free runs,
+// closed-loop clients
+//
+// Simulation parameters are derived from the seed, so any --sims
+// covers all windows evenly
+
+struct BenchConfig {
+  std::string mode;
+  size_t replicas;
+  size_t window;
+  size_t batch_size;
+  // Keys shared by all clients, 0 - a distinct key per client
+  size_t keys = 0;
+};
+
+static const std::vector<BenchConfig> kBenchConfigs{
+    // Window
+    {"leader", 3, 1, 1},
+    {"leader", 3, 2, 1},
+    {"leader", 3, 4, 1},
+    {"leader", 3, 8, 1},
+    {"leader", 3, 16, 1},
+    {"leader", 3, 32, 1},
+    {"leader", 3, 64, 1},
+    // Batching
+    {"leader", 3, 1, 64},
+    {"leader", 3, 8, 64},
+    // Rotating owners
+    {"mencius", 3, 8, 1},
+    {"leader", 5, 8, 1},
+    {"mencius", 5, 8, 1},
+    // Leaderless, contention
+    {"leader", 3, 8, 1, 0},
+    {"epaxos", 3, 8, 1, 0},
+    {"leader", 3, 8, 1, 1},
+    {"epaxos", 3, 8, 1, 1},
+    {"epaxos", 3, 8, 1, 16},
+    {"epaxos", 5, 8, 1, 0},
+};
+
+static const size_t kClients = 64;
+
+// Leader election is done by then
+static const matrix::TimePoint kWarmUp = 20000;
+static const Jiffies kTimeLimit = 60000_jfs;
+
+//////////////////////////////////////////////////////////////////////
+
+struct ThroughputStats {
+  size_t commands = 0;
+  uint64_t time = 0;
+
+  // Commands per 1000 jiffies
+  double Throughput() const {
+    return time > 0 ? 1000.0 * commands / time : 0;
+  }
+};
+
+static std::vector<ThroughputStats> throughput_stats(kBenchConfigs.size());
+
+// Current simulation
+static size_t bench_config = 0;
+
+//////////////////////////////////////////////////////////////////////
+
+void Client() {
+  await::fibers::self::SetName("main");
+
+  node::rt::SleepFor(123_jfs);
+
+  timber::Logger logger_{"Client", node::rt::LoggerBackend()};
+
+  auto channel = matrix::client::MakeRpcChannel("proxy", 42);
+
+  kv::Client kv_client{channel};
+
+  const size_t keys = kBenchConfigs[bench_config].keys;
+
+  // Disjoint keys by default, contention is irrelevant for the log
+  const auto own_key = node::rt::GenerateGuid();
+
+  for (size_t i = 0;; ++i) {
+    const auto key = (keys == 0)
+                         ? own_key
+                         : "key-" + std::to_string(node::rt::RandomNumber(keys));
+    kv_client.Set(key, std::to_string(i));
+
+    if (matrix::GlobalNow() >= kWarmUp) {
+      ++throughput_stats[bench_config].commands;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Seed -> simulation digest
+// Deterministic
+size_t RunSimulation(size_t seed) {
+  auto& runner = matrix::TestRunner::Access();
+
+  bench_config = seed % kBenchConfigs.size();
+  const auto& config = kBenchConfigs[bench_config];
+
+  runner.Verbose() << "Simulation seed: " << seed
+                   << ", mode: " << config.mode
+                   << ", replicas: " << config.replicas
+                   << ", window: " << config.window
+                   << ", batch size: " << config.batch_size
+                   << ", keys: " << config.keys << std::endl;
+
+  // Reset RPC ids
+  commute::rpc::ResetIds();
+
+  matrix::facade::World world{seed};
+
+  runner.Configure(world);
+
+  world.SetTimeModel(tests::MakeAsyncTimeModel());
+
+  // Cluster
+  world.MakePool("rsm", kv::ReplicaMain).Size(config.replicas);
+  world.MakePool("proxy", rsm::ProxyMain).Size(2);
+
+  // Clients
+  world.AddClients(Client, /*count=*/kClients);
+
+  // For proxies
+  world.SetGlobal<std::string>("config.rsm.pool.name", "rsm");
+
+  // For rsm
+  world.SetGlobal<std::string>("config.rsm.store.dir", "/rsm/store");
+  world.SetGlobal<std::string>("config.rsm.mode", config.mode);
+  world.SetGlobal<std::string>("config.rsm.store.log", "segmented");
+  world.SetGlobal<int64_t>("config.rsm.snapshot.slots", 0);
+  world.SetGlobal<int64_t>("config.rsm.snapshot.bytes", 0);
+  world.SetGlobal<int64_t>("config.rsm.apply.parallelism", 1);
+  // Unbounded in epaxos mode
+  world.SetGlobal<int64_t>("config.rsm.sessions.max",
+                           config.mode == "epaxos" ? 0 : 1024);
+  world.SetGlobal<int64_t>("config.rsm.catchup.chunk.bytes", 65536);
+
+  // For paxos
+  world.SetGlobal<int64_t>("config.paxos.backoff.init", 100);
+  world.SetGlobal<int64_t>("config.paxos.backoff.max", 2000);
+  world.SetGlobal<int64_t>("config.paxos.backoff.factor", 2);
+  world.SetGlobal<int64_t>("config.paxos.lease", 2000);
+  world.SetGlobal<int64_t>("config.paxos.window", (int64_t)config.window);
+  world.SetGlobal<int64_t>("config.paxos.batch.size",
+                           (int64_t)config.batch_size);
+  world.SetGlobal<int64_t>("config.paxos.batch.delay", 0);
+
+  // For mencius
+  world.SetGlobal<int64_t>("config.mencius.revoke.timeout", 1000);
+
+  // For epaxos
+  world.SetGlobal<int64_t>("config.epaxos.fast.timeout", 200);
+  world.SetGlobal<int64_t>("config.epaxos.recover.timeout", 1000);
+
+  // Run simulation
+
+  world.Start();
+  while (world.TimeElapsed() < kTimeLimit) {
+    if (!world.Step()) {
+      break;  // Deadlock
+    }
+  }
+
+  auto& stats = throughput_stats[bench_config];
+  stats.time += world.TimeElapsed().Count() - kWarmUp;
+
+  size_t digest = world.Stop();
+
+  if (world.TimeElapsed() < kTimeLimit) {
+    runner.Report() << "Simulation for seed = " << seed
+                    << " deadlocked" << std::endl;
+    runner.Fail();
+  }
+
+  return digest;
+}
+
+void PrintThroughputReport(std::ostream& out) {
+  out << "Write throughput, " << kClients << " clients:" << std::endl;
+  for (size_t i = 0; i < kBenchConfigs.size(); ++i) {
+    const auto& config = kBenchConfigs[i];
+    const auto& stats = throughput_stats[i];
+    out << "  " << config.mode << ", replicas = " << config.replicas
+        << ", window = " << config.window
+        << ", batch size = " << config.batch_size
+        << ", keys = " << config.keys << ": " << stats.Throughput()
+        << " commands / 1000 jiffies (" << stats.commands << " commands)"
+        << std::endl;
+  }
+}
+
+int main(int argc, const char** argv) {
+  int exit_code = matrix::Main(argc, argv, RunSimulation);
+  PrintThroughputReport(std::cout);
+  return exit_code;
+}
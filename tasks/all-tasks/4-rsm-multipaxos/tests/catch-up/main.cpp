@@ -0,0 +1,331 @@
+#include <kv/client.hpp>
+#include <kv/state_machine.hpp>
+#include <rsm/proxy/main.hpp>
+#include <rsm/replica/main.hpp>
+
+// Node
+#include <whirl/node/runtime/shortcuts.hpp>
+
+// Serialization
+#include <muesli/bytes.hpp>
+#include <muesli/serializable.hpp>
+#include <muesli/serialize.hpp>
+#include <cereal/types/string.hpp>
+
+// Logging
+#include <timber/log.hpp>
+
+// Concurrency
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/sync/future.hpp>
+
+// Simulation
+#include <matrix/facade/world.hpp>
+#include <matrix/world/global/vars.hpp>
+#include <matrix/world/global/time.hpp>
+#include <matrix/client/rpc.hpp>
+#include <matrix/test/main.hpp>
+#include <matrix/test/runner.hpp>
+
+#include <matrix/fault/access.hpp>
+#include <matrix/fault/util.hpp>
+
+#include <commute/rpc/id.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <tests/time_models/async.hpp>
+
+using namespace whirl;
+
+//////////////////////////////////////////////////////////////////////
+
+// Time-to-caught-up of a replica that missed a long stretch of the log:
+// the replica is paused while clients write, then rebooted and has to
+// learn every missed slot from peers (Replica.Fetch), from the log only
+// or via snapshot install when peers have compacted the prefix
+//
+// Simulation parameters are derived from the seed, so any --sims
+// covers all configs evenly
+
+struct CatchUpConfig {
+  // rsm.catchup.chunk.bytes
+  size_t chunk_bytes;
+  // rsm.snapshot.slots, 0 = disabled
+  size_t snapshot_slots;
+};
+
+static const std::vector<CatchUpConfig> kCatchUpConfigs{
+    // Log only
+    {256, 0},
+    {4096, 0},
+    {65536, 0},
+    // Compacted prefix
+    {4096, 256},
+};
+
+static const size_t kReplicas = 3;
+static const size_t kClients = 16;
+
+// Leader election is done by then
+static const matrix::TimePoint kOutageStart = 5000;
+// Clients stop writing, the victim is back
+static const matrix::TimePoint kOutageEnd = 25000;
+static const Jiffies kTimeLimit = 100000_jfs;
+
+//////////////////////////////////////////////////////////////////////
+
+struct CatchUpStats {
+  size_t runs = 0;
+  uint64_t time = 0;
+  // Commands reflected in the victim state machine when caught up
+  size_t commands = 0;
+
+  double MeanTime() const {
+    return runs > 0 ? 1.0 * time / runs : 0;
+  }
+};
+
+static std::vector<CatchUpStats> catch_up_stats(kCatchUpConfigs.size());
+
+// Current simulation
+static size_t catch_up_config = 0;
+// Host -> commands reflected in the state machine
+static std::map<std::string, size_t> applied;
+static std::string victim;
+static bool rebooted = false;
+
+//////////////////////////////////////////////////////////////////////
+
+// Counts applied commands, the count travels with snapshots
+
+class ProgressProbe : public rsm::IStateMachine {
+  struct ProbeSnapshot {
+    size_t applied;
+    muesli::Bytes state;
+
+    MUESLI_SERIALIZABLE(applied, state)
+  };
+
+ public:
+  explicit ProgressProbe(rsm::IStateMachinePtr impl)
+      : impl_(std::move(impl)) {
+  }
+
+  void Reset() override {
+    impl_->Reset();
+    Publish(0);
+  }
+
+  muesli::Bytes Apply(const rsm::Command& command) override {
+    Publish(count_ + 1);
+    return impl_->Apply(command);
+  }
+
+  muesli::Bytes MakeSnapshot() override {
+    return muesli::Serialize(ProbeSnapshot{count_, impl_->MakeSnapshot()});
+  }
+
+  void InstallSnapshot(const muesli::Bytes& snapshot) override {
+    auto probe = muesli::Deserialize<ProbeSnapshot>(snapshot);
+    impl_->InstallSnapshot(probe.state);
+    Publish(probe.applied);
+  }
+
+  std::optional<std::vector<std::string>> Footprint(
+      const rsm::Command& command) override {
+    return impl_->Footprint(command);
+  }
+
+ private:
+  void Publish(size_t count) {
+    count_ = count;
+    applied[node::rt::HostName()] = count_;
+  }
+
+ private:
+  rsm::IStateMachinePtr impl_;
+  size_t count_ = 0;
+};
+
+void ReplicaMain() {
+  rsm::ReplicaMain(std::make_shared<ProgressProbe>(kv::MakeStateMachine()));
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Client() {
+  await::fibers::self::SetName("main");
+
+  node::rt::SleepFor(123_jfs);
+
+  timber::Logger logger_{"Client", node::rt::LoggerBackend()};
+
+  auto channel = matrix::client::MakeRpcChannel("proxy", 42);
+
+  kv::Client kv_client{channel};
+
+  const auto key = node::rt::GenerateGuid();
+
+  for (size_t i = 0; matrix::GlobalNow() < kOutageEnd; ++i) {
+    kv_client.Set(key, std::to_string(i));
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Outage() {
+  timber::Logger logger_{"Outage", node::rt::LoggerBackend()};
+
+  auto pool = node::rt::Discovery()->ListPool("rsm");
+
+  node::rt::SleepFor(kOutageStart);
+
+  auto& server = matrix::fault::RandomServer(pool);
+  victim = server.Name();
+
+  LOG_INFO("Pause {}", victim);
+  server.Pause();
+
+  node::rt::SleepFor(kOutageEnd - kOutageStart);
+
+  // Back with an empty memory, durable log prefix only
+  LOG_INFO("Reboot {}", victim);
+  server.Resume();
+  server.FastReboot();
+  rebooted = true;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Victim applied everything its peers did
+bool CaughtUp() {
+  if (!rebooted) {
+    return false;
+  }
+
+  size_t target = 0;
+  for (const auto& [host, count] : applied) {
+    if (host != victim) {
+      target = std::max(target, count);
+    }
+  }
+
+  return applied[victim] >= target;
+}
+
+// Seed -> simulation digest
+// Deterministic
+size_t RunSimulation(size_t seed) {
+  auto& runner = matrix::TestRunner::Access();
+
+  catch_up_config = seed % kCatchUpConfigs.size();
+  const auto& config = kCatchUpConfigs[catch_up_config];
+
+  runner.Verbose() << "Simulation seed: " << seed
+                   << ", chunk bytes: " << config.chunk_bytes
+                   << ", snapshot slots: " << config.snapshot_slots
+                   << std::endl;
+
+  applied.clear();
+  victim.clear();
+  rebooted = false;
+
+  // Reset RPC ids
+  commute::rpc::ResetIds();
+
+  matrix::facade::World world{seed};
+
+  runner.Configure(world);
+
+  world.SetTimeModel(tests::MakeAsyncTimeModel());
+
+  // Cluster
+  world.MakePool("rsm", ReplicaMain).Size(kReplicas);
+  world.MakePool("proxy", rsm::ProxyMain).Size(2);
+
+  // Clients
+  world.AddClients(Client, /*count=*/kClients);
+
+  world.AddAdversary(Outage);
+
+  // For proxies
+  world.SetGlobal<std::string>("config.rsm.pool.name", "rsm");
+
+  // For rsm
+  world.SetGlobal<std::string>("config.rsm.store.dir", "/rsm/store");
+  world.SetGlobal<std::string>("config.rsm.mode", "leader");
+  world.SetGlobal<std::string>("config.rsm.store.log", "segmented");
+  world.SetGlobal<int64_t>("config.rsm.snapshot.slots",
+                           (int64_t)config.snapshot_slots);
+  world.SetGlobal<int64_t>("config.rsm.snapshot.bytes", 0);
+  world.SetGlobal<int64_t>("config.rsm.apply.parallelism", 1);
+  world.SetGlobal<int64_t>("config.rsm.sessions.max", 1024);
+  world.SetGlobal<int64_t>("config.rsm.catchup.chunk.bytes",
+                           (int64_t)config.chunk_bytes);
+
+  // For paxos
+  world.SetGlobal<int64_t>("config.paxos.backoff.init", 100);
+  world.SetGlobal<int64_t>("config.paxos.backoff.max", 2000);
+  world.SetGlobal<int64_t>("config.paxos.backoff.factor", 2);
+  world.SetGlobal<int64_t>("config.paxos.lease", 2000);
+  world.SetGlobal<int64_t>("config.paxos.window", 8);
+  world.SetGlobal<int64_t>("config.paxos.batch.size", 1);
+  world.SetGlobal<int64_t>("config.paxos.batch.delay", 0);
+
+  // Run simulation
+
+  world.Start();
+  while (!CaughtUp() && world.TimeElapsed() < kTimeLimit) {
+    if (!world.Step()) {
+      break;  // Deadlock
+    }
+  }
+
+  const bool caught_up = CaughtUp();
+
+  if (caught_up) {
+    auto& stats = catch_up_stats[catch_up_config];
+    ++stats.runs;
+    stats.time += world.TimeElapsed().Count() - kOutageEnd;
+    stats.commands += applied[victim];
+  }
+
+  size_t digest = world.Stop();
+
+  runner.Verbose() << "Seed " << seed << " -> "
+                   << "victim: " << victim
+                   << ", applied: " << applied[victim]
+                   << ", time: " << world.TimeElapsed() << std::endl;
+
+  if (!caught_up) {
+    runner.Report() << "Simulation for seed = " << seed << ": " << victim
+                    << " did not catch up" << std::endl;
+    runner.Fail();
+  }
+
+  return digest;
+}
+
+void PrintCatchUpReport(std::ostream& out) {
+  out << "Time to caught up after " << kOutageEnd - kOutageStart
+      << " jiffies outage, " << kClients << " clients:" << std::endl;
+  for (size_t i = 0; i < kCatchUpConfigs.size(); ++i) {
+    const auto& config = kCatchUpConfigs[i];
+    const auto& stats = catch_up_stats[i];
+    out << "  chunk bytes = " << config.chunk_bytes
+        << ", snapshot slots = " << config.snapshot_slots << ": "
+        << stats.MeanTime() << " jiffies (" << stats.runs << " runs, "
+        << stats.commands << " commands)" << std::endl;
+  }
+}
+
+int main(int argc, const char** argv) {
+  int exit_code = matrix::Main(argc, argv, RunSimulation);
+  PrintCatchUpReport(std::cout);
+  return exit_code;
+}
@@ -0,0 +1,187 @@
+#include <rsm/replica/batch.hpp>
+#include <rsm/replica/store/log.hpp>
+#include <rsm/replica/store/log_entry.hpp>
+
+// Node
+#include <whirl/node/runtime/shortcuts.hpp>
+
+// Concurrency
+#include <await/fibers/core/api.hpp>
+
+#include <wheels/support/panic.hpp>
+
+// Simulation
+#include <matrix/facade/world.hpp>
+#include <matrix/world/global/vars.hpp>
+#include <matrix/test/main.hpp>
+#include <matrix/test/runner.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace whirl;
+
+//////////////////////////////////////////////////////////////////////
+
+// Log backends (rsm.store.log) under the replica workload:
+// appends, random reads of recent / old slots and prefix truncation
+//
+// Simulated disk has no latency, so wall clock time measures
+// the CPU cost of the backend (indexing, serialization)
+//
+// Backend is derived from the seed, any even --sims covers both
+
+static const std::vector<std::string> kBackends{"file", "segmented"};
+
+static const size_t kEntries = 4096;
+static const size_t kReads = 4096;
+static const size_t kCommandBytes = 128;
+
+//////////////////////////////////////////////////////////////////////
+
+using Clock = std::chrono::steady_clock;
+
+struct LogStats {
+  size_t appends = 0;
+  size_t reads = 0;
+  Clock::duration append_time{0};
+  Clock::duration read_time{0};
+  Clock::duration truncate_time{0};
+};
+
+static std::vector<LogStats> log_stats(kBackends.size());
+
+// Current simulation
+static size_t backend = 0;
+
+//////////////////////////////////////////////////////////////////////
+
+static rsm::LogEntry MakeEntry(size_t index) {
+  rsm::Command command;
+  command.type = "Set";
+  command.request.assign(kCommandBytes, 'x');
+  command.request_id = {"client", index};
+  command.readonly = false;
+
+  rsm::LogEntry entry;
+  entry.promise = {index, "log-bench"};
+  entry.vote = rsm::paxos::Proposal{entry.promise, rsm::Batch{{command}}};
+  entry.chosen = true;
+  return entry;
+}
+
+void LogBench() {
+  await::fibers::self::SetName("main");
+
+  auto store_dir =
+      node::rt::Fs()->MakePath(node::rt::Config()->GetString("rsm.store.dir"));
+
+  rsm::Log log{store_dir};
+  log.Open();
+
+  auto& stats = log_stats[backend];
+
+  // Appends
+
+  {
+    auto start = Clock::now();
+    for (size_t index = 1; index <= kEntries; ++index) {
+      log.Update(index, MakeEntry(index));
+    }
+    stats.append_time += Clock::now() - start;
+    stats.appends += kEntries;
+  }
+
+  // Random reads
+
+  {
+    auto start = Clock::now();
+    for (size_t i = 0; i < kReads; ++i) {
+      auto index = node::rt::RandomNumber(1, kEntries);
+      if (!log.Read(index).has_value()) {
+        WHEELS_PANIC("Log entry " << index << " not found");
+      }
+    }
+    stats.read_time += Clock::now() - start;
+    stats.reads += kReads;
+  }
+
+  // Compaction
+
+  {
+    auto start = Clock::now();
+    log.TruncatePrefix(kEntries / 2);
+    stats.truncate_time += Clock::now() - start;
+  }
+
+  matrix::GlobalCounter("done").Increment();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Seed -> simulation digest
+// Deterministic
+size_t RunSimulation(size_t seed) {
+  auto& runner = matrix::TestRunner::Access();
+
+  backend = seed % kBackends.size();
+
+  runner.Verbose() << "Simulation seed: " << seed
+                   << ", backend: " << kBackends[backend] << std::endl;
+
+  matrix::facade::World world{seed};
+
+  runner.Configure(world);
+
+  world.MakePool("log", LogBench).Size(1);
+
+  world.InitCounter("done");
+
+  world.SetGlobal<std::string>("config.rsm.store.dir", "/rsm/store");
+  world.SetGlobal<std::string>("config.rsm.store.log", kBackends[backend]);
+
+  world.Start();
+  while (world.GetCounter("done") == 0) {
+    if (!world.Step()) {
+      break;  // Deadlock
+    }
+  }
+
+  size_t digest = world.Stop();
+
+  if (world.GetCounter("done") == 0) {
+    runner.Report() << "Simulation for seed = " << seed
+                    << " deadlocked" << std::endl;
+    runner.Fail();
+  }
+
+  return digest;
+}
+
+static double Micros(Clock::duration time) {
+  return std::chrono::duration<double, std::micro>(time).count();
+}
+
+static double PerOp(Clock::duration time, size_t ops) {
+  return ops > 0 ? Micros(time) / ops : 0;
+}
+
+void PrintLogReport(std::ostream& out) {
+  out << "Log backends, " << kEntries << " entries:" << std::endl;
+  for (size_t i = 0; i < kBackends.size(); ++i) {
+    const auto& stats = log_stats[i];
+    out << "  " << kBackends[i]
+        << ": append = " << PerOp(stats.append_time, stats.appends)
+        << " us, random read = " << PerOp(stats.read_time, stats.reads)
+        << " us, truncate prefix = " << Micros(stats.truncate_time)
+        << " us total" << std::endl;
+  }
+}
+
+int main(int argc, const char** argv) {
+  int exit_code = matrix::Main(argc, argv, RunSimulation);
+  PrintLogReport(std::cout);
+  return exit_code;
+}
@@ -183,13 +183,18 @@ size_t RunSimulation(size_t seed) {
   const size_t replicas = random.Get(3, 5);
   const size_t clients = random.Get(2, 3);
   const size_t increments_per_client = random.Get(2, 3);
+  // Stable leader or rotating slot owners
+  static const std::vector<std::string> kModes = {"leader", "mencius",
+                                                  "epaxos"};
+  const std::string mode = kModes[random.Get(0, kModes.size() - 1)];
 
   size_t increments = increments_per_client * clients;
 
   runner.Verbose() << "Parameters: "
       << "replicas = " << replicas << ", "
       << "clients = " << clients << ", "
-      << "increments_per_client = " << increments_per_client
+      << "increments_per_client = " << increments_per_client << ", "
+      << "mode = " << mode
       << std::endl;
 
   // Reset RPC ids
@@ -239,11 +244,30 @@ size_t RunSimulation(size_t seed) {
 
   // For rsm
   world.SetGlobal<std::string>("config.rsm.store.dir", "/rsm/store");
+  world.SetGlobal<std::string>("config.rsm.mode", mode);
+  world.SetGlobal<std::string>("config.rsm.store.log", "segmented");
+  world.SetGlobal<int64_t>("config.rsm.snapshot.slots", 64);
+  world.SetGlobal<int64_t>("config.rsm.snapshot.bytes", 4096);
+  world.SetGlobal<int64_t>("config.rsm.apply.parallelism", 4);
+  // Unbounded in epaxos mode
+  world.SetGlobal<int64_t>("config.rsm.sessions.max",
+                           mode == "epaxos" ? 0 : 1024);
+  world.SetGlobal<int64_t>("config.rsm.catchup.chunk.bytes", 65536);
 
   // For paxos
   world.SetGlobal<int64_t>("config.paxos.backoff.init", 100);
   world.SetGlobal<int64_t>("config.paxos.backoff.max", 3000);
   world.SetGlobal<int64_t>("config.paxos.backoff.factor", 2);
+  world.SetGlobal<int64_t>("config.paxos.lease", 2000);
+  world.SetGlobal<int64_t>("config.paxos.window", 8);
+  world.SetGlobal<int64_t>("config.paxos.batch.size", 16);
+  world.SetGlobal<int64_t>("config.paxos.batch.delay", 0);
+
+  // For mencius
+  world.SetGlobal<int64_t>("config.mencius.revoke.timeout", 1000);
+  // For epaxos
+  world.SetGlobal<int64_t>("config.epaxos.fast.timeout", 200);
+  world.SetGlobal<int64_t>("config.epaxos.recover.timeout", 1000);
 
   // Run simulation
 
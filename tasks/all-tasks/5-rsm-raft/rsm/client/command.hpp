@@ -27,7 +27,16 @@ struct Command {
   // Command metadata
   bool readonly;
 
-  MUESLI_SERIALIZABLE(type, request, request_id, readonly);
+  // Client has received responses for its requests with index <= acked
+  uint64_t acked = 0;
+
+  // Request index 0: opens a client session, the response is
+  // the serialized session id (see rsm::SessionTable)
+  bool OpensSession() const {
+    return request_id.index == 0;
+  }
+
+  MUESLI_SERIALIZABLE(type, request, request_id, readonly, acked);
 };
 
 //////////////////////////////////////////////////////////////////////
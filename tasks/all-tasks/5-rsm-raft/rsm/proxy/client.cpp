@@ -9,6 +9,8 @@
 #include <commute/rpc/client.hpp>
 #include <commute/rpc/errors.hpp>
 
+#include <stdexcept>
+
 using namespace whirl;
 
 namespace rsm {
@@ -72,6 +74,13 @@ muesli::Bytes ProxyClient::Execute(const Command& command) {
       ForgetLeader();
       node::rt::SleepFor(50_jfs);
       continue;
+    } else if (rsm_response.index() == 3) {
+      // Session expired, the command may have been applied:
+      // retrying it would break exactly-once
+      proto::SessionExpired expired = std::get<3>(rsm_response);
+      LOG_INFO("Session of client {} expired", expired.client_id);
+      throw std::runtime_error("Session of client " + expired.client_id +
+                               " expired");
     }
   }
 }
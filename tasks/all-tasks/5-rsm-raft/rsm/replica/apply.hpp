@@ -0,0 +1,44 @@
+#pragma once
+
+#include <rsm/client/command.hpp>
+#include <rsm/replica/state_machine.hpp>
+
+#include <muesli/bytes.hpp>
+
+#include <set>
+#include <string>
+#include <vector>
+
+namespace rsm {
+
+// Conflict-aware apply stage
+//
+// Consecutive commands with pairwise disjoint footprints
+// (see IStateMachine::Footprint) form a wave, commands of a wave are
+// applied concurrently in fibers, at most `parallelism` at a time.
+// Next wave starts when the previous one is complete, so commands
+// touching the same key are applied in log order and responses match
+// the sequential apply
+//
+// parallelism = 1 -> sequential apply, Footprint is not called
+//
+// NOT thread-safe, external synchronization required
+
+class Applier {
+ public:
+  Applier(IStateMachinePtr state_machine, size_t parallelism);
+
+  // Responses in command order
+  std::vector<muesli::Bytes> Apply(const std::vector<Command>& commands);
+
+ private:
+  // Commands [begin, end)
+  void ApplyWave(const std::vector<Command>& commands, size_t begin,
+                 size_t end, std::vector<muesli::Bytes>& responses);
+
+ private:
+  IStateMachinePtr state_machine_;
+  const size_t parallelism_;
+};
+
+}  // namespace rsm
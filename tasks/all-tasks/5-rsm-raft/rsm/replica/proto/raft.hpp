@@ -42,7 +42,8 @@ struct AppendEntries {
     std::string leader;
     uint64_t prev_log_index;
     uint64_t prev_log_term;
-    LogEntries entries;
+    // Serialized once by the leader, persisted by followers as is
+    EncodedLogEntries entries;
     uint64_t leader_commit_index;
 
     MUESLI_SERIALIZABLE(term, leader, prev_log_index, prev_log_term, entries,
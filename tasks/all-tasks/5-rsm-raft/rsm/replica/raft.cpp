@@ -1,6 +1,8 @@
 #include <rsm/replica/raft.hpp>
 
+#include <rsm/replica/apply.hpp>
 #include <rsm/replica/proto/raft.hpp>
+#include <rsm/replica/session.hpp>
 #include <rsm/replica/store/log.hpp>
 
 #include <commute/rpc/call.hpp>
@@ -14,9 +16,19 @@
 
 #include <whirl/node/runtime/shortcuts.hpp>
 #include <whirl/node/cluster/peer.hpp>
+#include <whirl/node/store/kv.hpp>
 
+#include <muesli/serializable.hpp>
+#include <muesli/serialize.hpp>
+#include <cereal/types/optional.hpp>
+#include <cereal/types/string.hpp>
+
+#include <algorithm>
+#include <map>
 #include <mutex>
 #include <optional>
+#include <string>
+#include <vector>
 
 using await::futures::Future;
 using await::futures::Promise;
@@ -35,27 +47,95 @@ class Raft : public IReplica,
              public commute::rpc::ServiceBase<Raft>,
              public node::cluster::Peer,
              public std::enable_shared_from_this<Raft> {
+  // currentTerm + votedFor
+  struct PersistentState {
+    uint64_t term = 0;
+    std::optional<std::string> voted_for;
+
+    MUESLI_SERIALIZABLE(term, voted_for)
+  };
+
+  struct Waiter {
+    RequestId request_id;
+    Promise<proto::Response> promise;
+  };
+
+  // Leader: not yet in the log, see RunBatcher
+  struct PendingCommand {
+    Command command;
+    Promise<proto::Response> promise;
+  };
+
+  using Wakeup = await::fibers::Channel<bool>;
+
+  // Leader: replication pipeline to a single follower
+  struct Pipeline {
+    // Wakes up RunAppendEntries
+    Wakeup wakeup{1};
+    // Unacknowledged AppendEntries and their entries payload
+    size_t in_flight = 0;
+    size_t in_flight_bytes = 0;
+    // Send AppendEntries even without new entries
+    bool heartbeat = true;
+    // Bumped by rewinds, rejections of older requests are stale
+    uint64_t epoch = 0;
+  };
+
  public:
   Raft(IStateMachinePtr state_machine, persist::fs::Path store_dir)
       : Peer(node::rt::Config()),
         state_machine_(std::move(state_machine)),
+        applier_(state_machine_,
+                 node::rt::Config()->GetInt<size_t>("rsm.apply.parallelism")),
         log_(node::rt::Fs(), store_dir),
+        state_store_(node::rt::Database(), "raft"),
+        commits_(1),
+        sessions_(node::rt::Config()->GetInt<size_t>("rsm.sessions.max")),
         logger_("Raft", node::rt::LoggerBackend()) {
   }
 
   Future<proto::Response> Execute(Command command) override {
     auto [future, promise] = await::futures::MakeContract<proto::Response>();
 
-    {
-      std::lock_guard guard(mutex_);
-      auto response = state_machine_->Apply(command);
-      std::move(promise).SetValue(proto::Ack{response});
+    std::lock_guard guard(mutex_);
+
+    if (state_ != NodeState::Leader) {
+      if (leader_.has_value()) {
+        std::move(promise).SetValue(proto::RedirectToLeader{*leader_});
+      } else {
+        std::move(promise).SetValue(proto::NotALeader{});
+      }
+      return std::move(future);
     }
 
+    LOG_INFO("Executing command {}", command);
+
+    pending_.push_back({std::move(command), std::move(promise)});
+    batcher_->TrySend(true);
+
     return std::move(future);
   };
 
-  void Start(commute::rpc::IServer* /*rpc_server*/) {
+  void Start(commute::rpc::IServer* rpc_server) {
+    // Reset state machine state, committed prefix of the log is replayed
+    state_machine_->Reset();
+
+    log_.Open();
+
+    auto state = state_store_.GetOr(kStateKey, PersistentState{});
+
+    await::fibers::Go([this]() {
+      ApplyCommittedCommands();
+    });
+
+    {
+      std::lock_guard guard(mutex_);
+      term_ = state.term;
+      voted_for_ = state.voted_for;
+      BecomeFollower(term_);
+    }
+
+    rpc_server->RegisterService("Raft", shared_from_this());
   }
 
  protected:
@@ -68,95 +148,781 @@ class Raft : public IReplica,
 
   // Leader election
 
-  void RequestVote(const raft::proto::RequestVote::Request& /*request*/,
-                   raft::proto::RequestVote::Response* /*response*/) {
-    // Your code goes here
+  void RequestVote(const raft::proto::RequestVote::Request& request,
+                   raft::proto::RequestVote::Response* response) {
+    std::lock_guard guard(mutex_);
+
+    if (request.term > term_) {
+      BecomeFollower(request.term);
+    }
+
+    response->term = term_;
+    response->vote_granted = false;
+
+    if (request.term < term_) {
+      return;
+    }
+
+    if (voted_for_.has_value() && *voted_for_ != request.candidate) {
+      return;
+    }
+
+    // Candidate log is at least as up-to-date as ours
+    auto last_log_term = log_.LastLogTerm();
+    bool up_to_date = request.last_log_term > last_log_term ||
+                      (request.last_log_term == last_log_term &&
+                       request.last_log_index >= log_.Length());
+    if (!up_to_date) {
+      return;
+    }
+
+    LOG_INFO("Vote for {} in term {}", request.candidate, term_);
+
+    voted_for_ = request.candidate;
+    Persist();
+    ResetElectionDeadline();
+
+    response->vote_granted = true;
   }
 
   // Replication
 
-  void AppendEntries(const raft::proto::AppendEntries::Request& /*request*/,
-                     raft::proto::AppendEntries::Response* /*response*/) {
-    // Your code goes here
+  void AppendEntries(const raft::proto::AppendEntries::Request& request,
+                     raft::proto::AppendEntries::Response* response) {
+    std::lock_guard guard(mutex_);
+
+    response->term = term_;
+    response->success = false;
+    response->next_index_hint = 0;
+
+    if (request.term < term_) {
+      return;  // Stale leader
+    }
+
+    if (request.term > term_ || state_ != NodeState::Follower) {
+      BecomeFollower(request.term);
+    }
+
+    response->term = term_;
+
+    leader_ = request.leader;
+    ResetElectionDeadline();
+
+    // Consistency check
+
+    if (request.prev_log_index > log_.Length()) {
+      response->next_index_hint = log_.Length() + 1;
+      return;
+    }
+
+    if (log_.Term(request.prev_log_index) != request.prev_log_term) {
+      // Skip the whole conflicting term
+      auto conflict_term = log_.Term(request.prev_log_index);
+      auto index = request.prev_log_index;
+      while (index > commit_index_ + 1 &&
+             log_.Term(index - 1) == conflict_term) {
+        --index;
+      }
+      response->next_index_hint = index;
+      return;
+    }
+
+    // Append entries not already in the log
+
+    const auto& entries = request.entries;
+
+    size_t offset = 0;
+    for (; offset < entries.size(); ++offset) {
+      auto index = request.prev_log_index + 1 + offset;
+      if (index > log_.Length()) {
+        break;
+      }
+      if (log_.Term(index) != entries[offset].term) {
+        log_.TruncateSuffix(index);
+        break;
+      }
+    }
+
+    if (offset < entries.size()) {
+      log_.Append(entries, offset);
+    }
+
+    auto last_new_index = request.prev_log_index + entries.size();
+
+    if (request.leader_commit_index > commit_index_) {
+      auto commit_index =
+          std::min<size_t>(request.leader_commit_index, last_new_index);
+      if (commit_index > commit_index_) {
+        commit_index_ = commit_index;
+        commits_.TrySend(true);
+      }
+    }
+
+    response->success = true;
+    response->next_index_hint = last_new_index + 1;
   }
 
  private:
   // State changes
 
   // With mutex
-  void BecomeFollower(size_t /*term*/) {
-    // Your code goes here
+  void BecomeFollower(size_t term) {
+    if (state_ == NodeState::Leader) {
+      LOG_INFO("Step down in term {}", term_);
+      StopReplication();
+      FailWaiters();
+    }
+
+    if (term > term_) {
+      term_ = term;
+      voted_for_.reset();
+      leader_.reset();
+      Persist();
+    }
+
+    state_ = NodeState::Follower;
+
+    ResetElectionDeadline();
+    StartElectionTimer();
   }
 
   // With mutex
   void BecomeCandidate() {
-    // Your code goes here
+    ++term_;
+    state_ = NodeState::Candidate;
+    voted_for_ = node::rt::HostName();
+    leader_.reset();
+    Persist();
+
+    LOG_INFO("Start election in term {}", term_);
+
+    votes_ = 1;
+    if (votes_ >= Majority()) {
+      BecomeLeader();
+      return;
+    }
+
+    for (const auto& peer : ListPeers().WithoutMe()) {
+      await::fibers::Go([this, peer, term = term_]() {
+        RunRequestVote(peer, term);
+      });
+    }
+
+    ResetElectionDeadline();
+    StartElectionTimer();
   }
 
   // With mutex
   void BecomeLeader() {
-    // Your code goes here
+    LOG_INFO("Become leader in term {}", term_);
+
+    state_ = NodeState::Leader;
+    leader_ = node::rt::HostName();
+
+    // Commits entries of previous terms, see Raft paper, 5.4.2
+    log_.Append({LogEntry{Command{}, term_}});
+
+    next_index_.clear();
+    match_index_.clear();
+    pipelines_.clear();
+
+    for (const auto& peer : ListPeers().WithoutMe()) {
+      next_index_[peer] = log_.Length();
+      match_index_[peer] = 0;
+
+      auto wakeup = pipelines_[peer].wakeup;
+
+      await::fibers::Go([this, peer, term = term_, wakeup]() mutable {
+        RunAppendEntries(peer, term, wakeup);
+      });
+    }
+
+    await::fibers::Go([this, term = term_]() {
+      Replicate(term);
+    });
+
+    batcher_.emplace(1);
+    batch_limit_ = kMinBatch;
+
+    await::fibers::Go([this, term = term_, wakeup = *batcher_]() mutable {
+      RunBatcher(term, wakeup);
+    });
+
+    WakeReplication();
+    AdvanceCommitIndex();
   }
 
  private:
   // Fibers
 
+  // Applies committed prefix of the log in order
   void ApplyCommittedCommands() {
-    // Your code goes here
+    while (true) {
+      commits_.Receive();
+
+      while (ApplyCommittedChunk()) {
+        // Keep applying
+      }
+    }
   }
 
-  void RunElectionTimer(size_t /*term*/) {
-    // Your code goes here
+  // Becomes candidate if no leader was heard of for the election timeout
+  void RunElectionTimer(size_t term) {
+    while (true) {
+      Jiffies sleep = 0;
+
+      {
+        std::lock_guard guard(mutex_);
+
+        if (term_ != term || state_ == NodeState::Leader) {
+          return;
+        }
+
+        auto now = node::rt::MonotonicNow().ToJiffies();
+        if (now.Count() >= election_deadline_.Count()) {
+          BecomeCandidate();
+          return;
+        }
+
+        sleep = election_deadline_.Count() - now.Count();
+      }
+
+      node::rt::SleepFor(sleep);
+    }
   }
 
-  void RunRequestVote(std::string /*peer*/, size_t /*term*/) {
-    // Your code goes here
+  void RunRequestVote(std::string peer, size_t term) {
+    raft::proto::RequestVote::Request request;
+
+    {
+      std::lock_guard guard(mutex_);
+      if (term_ != term || state_ != NodeState::Candidate) {
+        return;
+      }
+      request = {term, node::rt::HostName(), log_.Length(),
+                 log_.LastLogTerm()};
+    }
+
+    auto result = await::fibers::Await(
+        commute::rpc::Call("Raft.RequestVote")
+            .Args(request)
+            .Via(Channel(peer))
+            .Context(await::context::ThisFiber())
+            .AtMostOnce()
+            .Start()
+            .As<raft::proto::RequestVote::Response>());
+
+    if (!result.IsOk()) {
+      return;  // Next election
+    }
+
+    auto response = std::move(result).ValueOrThrow();
+
+    std::lock_guard guard(mutex_);
+
+    if (response.term > term_) {
+      BecomeFollower(response.term);
+      return;
+    }
+
+    if (term_ != term || state_ != NodeState::Candidate ||
+        !response.vote_granted) {
+      return;
+    }
+
+    if (++votes_ >= Majority()) {
+      BecomeLeader();
+    }
   }
 
-  void RunAppendEntries(std::string /*peer*/, size_t /*term*/) {
-    // Your code goes here
+  // Replicates log to peer, woken up by new entries, heartbeats and
+  // acknowledgements
+  //
+  // Pipelined: up to kMaxInFlight AppendEntries with at most
+  // kMaxInFlightBytes of entries are unacknowledged, next_index_ advances
+  // as requests are sent. Rejection rewinds next_index_ to the hint
+  void RunAppendEntries(std::string peer, size_t term, Wakeup wakeup) {
+    while (true) {
+      wakeup.Receive();
+
+      std::lock_guard guard(mutex_);
+
+      if (term_ != term || state_ != NodeState::Leader) {
+        return;
+      }
+
+      auto& pipeline = pipelines_.at(peer);
+
+      while (pipeline.in_flight < kMaxInFlight &&
+             pipeline.in_flight_bytes < kMaxInFlightBytes) {
+        bool has_entries = next_index_[peer] <= log_.Length();
+        if (!has_entries && !pipeline.heartbeat) {
+          break;
+        }
+        pipeline.heartbeat = false;
+
+        size_t bytes = 0;
+        auto request = MakeAppendEntries(peer, bytes);
+
+        ++pipeline.in_flight;
+        pipeline.in_flight_bytes += bytes;
+
+        await::fibers::Go([this, peer, term, request = std::move(request),
+                           bytes, epoch = pipeline.epoch]() {
+          SendAppendEntries(peer, term, request, bytes, epoch);
+        });
+      }
+    }
   }
 
-  void Replicate(size_t /*term*/) {
-    // Your code goes here
+  // With mutex
+  // Entries from next_index_[peer], up to kMaxRequestBytes (at least one)
+  raft::proto::AppendEntries::Request MakeAppendEntries(
+      const std::string& peer, size_t& bytes) {
+    raft::proto::AppendEntries::Request request;
+
+    auto next_index = next_index_[peer];
+
+    request.term = term_;
+    request.leader = node::rt::HostName();
+    request.prev_log_index = next_index - 1;
+    request.prev_log_term = log_.Term(next_index - 1);
+    request.leader_commit_index = commit_index_;
+
+    for (auto index = next_index;
+         index <= log_.Length() &&
+         (request.entries.empty() || bytes < kMaxRequestBytes);
+         ++index) {
+      // Serialized once, when AppendBatch writes the entry to the log
+      request.entries.push_back(log_.ReadEncoded(index));
+      bytes += request.entries.back().data.size();
+    }
+
+    // Optimistically
+    next_index_[peer] = next_index + request.entries.size();
+
+    return request;
+  }
+
+  void SendAppendEntries(std::string peer, size_t term,
+                         raft::proto::AppendEntries::Request request,
+                         size_t bytes, uint64_t epoch) {
+    auto result = await::fibers::Await(
+        commute::rpc::Call("Raft.AppendEntries")
+            .Args(request)
+            .Via(Channel(peer))
+            .Context(await::context::ThisFiber())
+            .AtMostOnce()
+            .Start()
+            .As<raft::proto::AppendEntries::Response>());
+
+    std::lock_guard guard(mutex_);
+
+    if (result.IsOk() && result->term > term_) {
+      BecomeFollower(result->term);
+      return;
+    }
+
+    if (term_ != term || state_ != NodeState::Leader) {
+      return;
+    }
+
+    auto& pipeline = pipelines_.at(peer);
+
+    --pipeline.in_flight;
+    pipeline.in_flight_bytes -= bytes;
+
+    if (!result.IsOk()) {
+      // Later requests fail the consistency check,
+      // resend from the last acknowledged entry
+      Rewind(peer, match_index_[peer] + 1);
+    } else if (result->success) {
+      auto match_index = request.prev_log_index + request.entries.size();
+      match_index_[peer] = std::max(match_index_[peer], match_index);
+      next_index_[peer] = std::max(next_index_[peer], match_index + 1);
+
+      AdvanceCommitIndex();
+    } else if (epoch == pipeline.epoch) {
+      Rewind(peer, std::min<size_t>(result->next_index_hint,
+                                    request.prev_log_index));
+    }
+
+    pipeline.wakeup.TrySend(true);
+  }
+
+  // With mutex
+  void Rewind(const std::string& peer, size_t next_index) {
+    auto& pipeline = pipelines_.at(peer);
+    ++pipeline.epoch;
+    next_index_[peer] =
+        std::max<size_t>({next_index, match_index_[peer] + 1, 1});
+  }
+
+  // Appends commands accumulated while the previous batch was
+  // replicated: one Log::Append, shipped in one AppendEntries
+  //
+  // Flushes once batch_limit_ commands are pending, when the log is
+  // fully committed (idle leader, no reason to wait) or on heartbeat.
+  // The limit doubles while batches fill it and halves while they
+  // stay under half of it, within [kMinBatch, kMaxBatch]
+  void RunBatcher(size_t term, Wakeup wakeup) {
+    while (true) {
+      wakeup.Receive();
+
+      std::lock_guard guard(mutex_);
+
+      if (term_ != term || state_ != NodeState::Leader) {
+        return;
+      }
+
+      if (pending_.empty()) {
+        continue;
+      }
+
+      bool full = pending_.size() >= batch_limit_;
+      bool idle = commit_index_ == log_.Length();
+      if (!full && !idle && !flush_due_) {
+        continue;
+      }
+      flush_due_ = false;
+
+      AppendBatch();
+    }
+  }
+
+  // With mutex
+  void AppendBatch() {
+    auto size = std::min(pending_.size(), batch_limit_);
+
+    LOG_INFO("Append batch of {} commands to log at index {}", size,
+             log_.Length() + 1);
+
+    LogEntries entries;
+    for (size_t i = 0; i < size; ++i) {
+      auto& pending = pending_[i];
+      waiters_.emplace(log_.Length() + 1 + i,
+                       Waiter{pending.command.request_id,
+                              std::move(pending.promise)});
+      entries.push_back({std::move(pending.command), term_});
+    }
+    pending_.erase(pending_.begin(), pending_.begin() + size);
+
+    log_.Append(entries);
+
+    if (size == batch_limit_) {
+      batch_limit_ = std::min(batch_limit_ * 2, kMaxBatch);
+    } else if (size < batch_limit_ / 2) {
+      batch_limit_ = std::max(batch_limit_ / 2, kMinBatch);
+    }
+
+    WakeReplication();
+    AdvanceCommitIndex();
+
+    if (!pending_.empty()) {
+      batcher_->TrySend(true);
+    }
+  }
+
+  // Heartbeats
+  void Replicate(size_t term) {
+    while (true) {
+      node::rt::SleepFor(HeartbeatPeriod());
+
+      std::lock_guard guard(mutex_);
+
+      if (term_ != term || state_ != NodeState::Leader) {
+        return;
+      }
+
+      for (auto& [_, pipeline] : pipelines_) {
+        pipeline.heartbeat = true;
+      }
+      WakeReplication();
+
+      flush_due_ = true;
+      batcher_->TrySend(true);
+    }
   }
 
  private:
+  // Up to kApplyChunk committed entries, false if there are none
+  //
+  // Committed entries never change and only this fiber touches the state
+  // machine and sessions, so commands are applied without the mutex:
+  // Execute, AppendEntries and elections are not blocked by the apply
+  bool ApplyCommittedChunk() {
+    size_t begin;
+    std::vector<LogEntry> entries;
+
+    {
+      std::lock_guard guard(mutex_);
+
+      begin = last_applied_ + 1;
+      for (auto index = begin;
+           index <= commit_index_ && entries.size() < kApplyChunk; ++index) {
+        entries.push_back(log_.Read(index));
+      }
+    }
+
+    if (entries.empty()) {
+      return false;
+    }
+
+    auto responses = ApplyEntries(begin, entries);
+
+    std::lock_guard guard(mutex_);
+
+    last_applied_ = begin + entries.size() - 1;
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+      const auto& command = entries[i].command;
+
+      if (auto it = waiters_.find(begin + i); it != waiters_.end()) {
+        if (!IsNop(command) && it->second.request_id == command.request_id) {
+          std::move(it->second.promise).SetValue(std::move(responses[i]));
+        } else {
+          std::move(it->second.promise).SetValue(proto::NotALeader{});
+        }
+        waiters_.erase(it);
+      }
+    }
+
+    return true;
+  }
+
+  // No-op, see BecomeLeader: the only command without a client
+  // (a session-opening command has an empty type too)
+  static bool IsNop(const Command& command) {
+    return command.request_id.client_id.empty();
+  }
+
+  // Without mutex, see ApplyCommittedChunk
+  // Responses in entry order, commands with disjoint footprints are
+  // applied concurrently (see Applier)
+  std::vector<proto::Response> ApplyEntries(
+      size_t begin, const std::vector<LogEntry>& entries) {
+    std::vector<proto::Response> responses(entries.size());
+
+    // Exactly-once: retries are answered from the session table
+    std::vector<Command> fresh;
+    // Entry of every fresh command
+    std::vector<size_t> positions;
+    // Retries within the chunk: entry -> entry of the first copy
+    std::vector<std::pair<size_t, size_t>> retries;
+    std::map<RequestId, size_t> first;
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+      const auto& command = entries[i].command;
+
+      if (IsNop(command)) {
+        continue;
+      }
+
+      if (auto it = first.find(command.request_id); it != first.end()) {
+        retries.emplace_back(i, it->second);
+        continue;
+      }
+      first.emplace(command.request_id, i);
+
+      if (command.OpensSession()) {
+        // Log index makes the session id unique
+        auto client_id = SessionTable::MakeSessionId(command, begin + i);
+        sessions_.Open(client_id);
+        responses[i] = proto::Ack{muesli::Serialize(client_id)};
+        continue;
+      }
+
+      const auto& client_id = command.request_id.client_id;
+      if (!sessions_.Has(client_id)) {
+        // Evicted: the command may have been applied already
+        responses[i] = proto::SessionExpired{client_id};
+        continue;
+      }
+
+      sessions_.Acknowledge(command);
+      if (auto response = sessions_.Lookup(command.request_id)) {
+        // Retry, do not apply twice
+        responses[i] = proto::Ack{std::move(*response)};
+        continue;
+      }
+
+      fresh.push_back(command);
+      positions.push_back(i);
+    }
+
+    auto results = applier_.Apply(fresh);
+
+    for (size_t k = 0; k < results.size(); ++k) {
+      sessions_.Record(fresh[k].request_id, results[k]);
+      responses[positions[k]] = proto::Ack{std::move(results[k])};
+    }
+
+    for (auto [retry, original] : retries) {
+      responses[retry] = responses[original];
+    }
+
+    return responses;
+  }
+
+  // With mutex
+  // Entry of the current term replicated on a majority is committed
+  void AdvanceCommitIndex() {
+    if (state_ != NodeState::Leader) {
+      return;
+    }
+
+    std::vector<size_t> match_indices{log_.Length()};
+    for (const auto& [_, match_index] : match_index_) {
+      match_indices.push_back(match_index);
+    }
+
+    std::sort(match_indices.begin(), match_indices.end(),
+              std::greater<size_t>());
+
+    auto index = match_indices[Majority() - 1];
+
+    if (index > commit_index_ && log_.Term(index) == term_) {
+      commit_index_ = index;
+      commits_.TrySend(true);
+      // Replication round is over, flush commands accumulated meanwhile
+      batcher_->TrySend(true);
+    }
+  }
+
+  // With mutex
+  void WakeReplication() {
+    for (auto& [_, pipeline] : pipelines_) {
+      pipeline.wakeup.TrySend(true);
+    }
+  }
+
+  // With mutex
+  void StopReplication() {
+    // Replication fibers observe the role change and exit
+    WakeReplication();
+    pipelines_.clear();
+
+    batcher_->TrySend(true);
+    batcher_.reset();
+  }
+
+  // With mutex
+  // Commands may still be committed, clients retry
+  void FailWaiters() {
+    for (auto& [_, waiter] : waiters_) {
+      std::move(waiter.promise).SetValue(proto::NotALeader{});
+    }
+    waiters_.clear();
+
+    for (auto& pending : pending_) {
+      std::move(pending.promise).SetValue(proto::NotALeader{});
+    }
+    pending_.clear();
+  }
+
+  // With mutex
+  void StartElectionTimer() {
+    if (timer_term_ == term_) {
+      return;  // Already running
+    }
+    timer_term_ = term_;
+
+    await::fibers::Go([this, term = term_]() {
+      RunElectionTimer(term);
+    });
+  }
+
+  // With mutex
+  void ResetElectionDeadline() {
+    election_deadline_ =
+        node::rt::MonotonicNow().ToJiffies().Count() + ElectionTimeout().Count();
+  }
+
+  // With mutex
+  void Persist() {
+    state_store_.Put(kStateKey, PersistentState{term_, voted_for_});
+  }
+
+  size_t Majority() const {
+    return NodeCount() / 2 + 1;
+  }
+
   Jiffies ElectionTimeout() const {
     uint64_t rtt = node::rt::Config()->GetInt<uint64_t>("net.rtt");
-    // Your code goes here
-    return Jiffies{2 * rtt};
+    // Randomized to split votes rarely
+    return Jiffies{node::rt::RandomNumber(5 * rtt, 10 * rtt)};
   }
 
-  void PleaseCompiler() {
-    WHEELS_UNUSED(log_);
-    WHEELS_UNUSED(term_);
-    WHEELS_UNUSED(state_);
-    WHEELS_UNUSED(voted_for_);
-    WHEELS_UNUSED(next_index_);
-    WHEELS_UNUSED(match_index_);
-    WHEELS_UNUSED(commit_index_);
+  Jiffies HeartbeatPeriod() const {
+    uint64_t rtt = node::rt::Config()->GetInt<uint64_t>("net.rtt");
+    return Jiffies{rtt};
   }
 
  private:
+  // Replication flow control, per follower
+  static const size_t kMaxInFlight = 8;
+  static const size_t kMaxInFlightBytes = 1 << 20;
+  // Entries payload per AppendEntries
+  static const size_t kMaxRequestBytes = 64 * 1024;
+  // Commands per Log::Append, see RunBatcher
+  static const size_t kMinBatch = 1;
+  static const size_t kMaxBatch = 256;
+  // Committed entries per apply round, see ApplyCommittedChunk
+  static const size_t kApplyChunk = 256;
+
+  static inline const std::string kStateKey = "state";
+
   await::fibers::Mutex mutex_;
 
   IStateMachinePtr state_machine_;
+  // rsm.apply.parallelism
+  Applier applier_;
 
   Log log_;
 
+  node::store::KVStore<PersistentState> state_store_;
+
   size_t term_{0};
-  NodeState state_;
+  NodeState state_{NodeState::Follower};
 
   std::optional<std::string> leader_;
   std::optional<std::string> voted_for_;
 
+  // Candidate
+  size_t votes_{0};
+
+  // Follower / candidate
+  Jiffies election_deadline_{0};
+  // Term of the running election timer
+  std::optional<size_t> timer_term_;
+
+  // Leader
+
   // Peer -> next index id
   std::map<std::string, size_t> next_index_;
   // Peer -> match index id
   std::map<std::string, size_t> match_index_;
+  // Peer -> replication pipeline
+  std::map<std::string, Pipeline> pipelines_;
+  // Log index -> pending Execute call
+  std::map<size_t, Waiter> waiters_;
+  // Commands waiting for the next batch
+  std::vector<PendingCommand> pending_;
+  // Wakes up RunBatcher
+  std::optional<Wakeup> batcher_;
+  // Adaptive, [kMinBatch, kMaxBatch]
+  size_t batch_limit_{kMinBatch};
+  bool flush_due_{false};
 
   size_t commit_index_{0};
+  // Guarded by mutex_, advanced by the apply fiber only
+  size_t last_applied_{0};
+  // Wakes up ApplyCommittedCommands
+  await::fibers::Channel<bool> commits_;
+
+  // rsm.sessions.max
+  // Guarded by the apply fiber, see ApplyCommittedChunk
+  SessionTable sessions_;
 
   timber::Logger logger_;
 };
@@ -4,6 +4,8 @@
 
 #include <muesli/serialize.hpp>
 
+#include <algorithm>
+
 namespace rsm {
 
 Log::Log(persist::fs::IFileSystem* fs, const persist::fs::Path& store_dir)
@@ -12,27 +14,56 @@ Log::Log(persist::fs::IFileSystem* fs, const persist::fs::Path& store_dir)
 
 void Log::Open() {
   impl_->Open();
+
+  length_ = impl_->Length();
+  // Filled on demand
+  terms_begin_ = length_ + 1;
 }
 
 LogEntry Log::Read(size_t index) const {
-  auto bytes = impl_->Read(index);
-  return muesli::Deserialize<LogEntry>(bytes);
+  if (auto* cached = FindCached(index)) {
+    if (!cached->entry.has_value()) {
+      cached->entry = muesli::Deserialize<LogEntry>(cached->data);
+    }
+    return *cached->entry;
+  }
+
+  auto data = impl_->Read(index);
+  auto entry = muesli::Deserialize<LogEntry>(data);
+  if (InTail(index)) {
+    Cache(index, {std::move(data), entry});
+  }
+  return entry;
+}
+
+EncodedLogEntry Log::ReadEncoded(size_t index) const {
+  auto term = Term(index);
+
+  if (auto* cached = FindCached(index)) {
+    return {term, cached->data};
+  }
+
+  auto data = impl_->Read(index);
+  if (InTail(index)) {
+    Cache(index, {data, std::nullopt});
+  }
+  return {term, std::move(data)};
 }
 
 size_t Log::Length() const {
-  return impl_->Length();
+  return length_;
 }
 
 uint64_t Log::Term(size_t index) const {
-  return Read(index).term;
+  if (index == 0) {
+    return 0;
+  }
+  IndexTerms(index);
+  return terms_[index - terms_begin_];
 }
 
 uint64_t Log::LastLogTerm() const {
-  size_t length = Length();
-  if (length == 0) {
-    return 0;
-  }
-  return Read(length).term;
+  return Term(length_);
 }
 
 void Log::Append(const LogEntries& entries, size_t start_offset) {
@@ -41,14 +72,58 @@ void Log::Append(const LogEntries& entries, size_t start_offset) {
     persist_entries.push_back(muesli::Serialize(entries[i]));
   }
   impl_->Append(persist_entries);
+
+  for (size_t i = start_offset; i < entries.size(); ++i) {
+    ++length_;
+    terms_.push_back(entries[i].term);
+    Cache(length_,
+          {std::move(persist_entries[i - start_offset]), entries[i]});
+  }
+}
+
+void Log::Append(const EncodedLogEntries& entries, size_t start_offset) {
+  persist::rsm::raft::Entries persist_entries;
+  for (size_t i = start_offset; i < entries.size(); ++i) {
+    persist_entries.push_back(entries[i].data);
+  }
+  impl_->Append(persist_entries);
+
+  for (size_t i = start_offset; i < entries.size(); ++i) {
+    ++length_;
+    terms_.push_back(entries[i].term);
+    // Decoded once, by apply
+    Cache(length_, {std::move(persist_entries[i - start_offset]),
+                    std::nullopt});
+  }
 }
 
 void Log::TruncateSuffix(size_t from_index) {
   impl_->TruncateSuffix(from_index);
+
+  if (from_index > length_) {
+    return;
+  }
+
+  cache_.erase(cache_.lower_bound(from_index), cache_.end());
+
+  while (!terms_.empty() && terms_begin_ + terms_.size() > from_index) {
+    terms_.pop_back();
+  }
+
+  length_ = from_index - 1;
+  terms_begin_ = std::min(terms_begin_, length_ + 1);
 }
 
 void Log::TruncatePrefix(size_t end_index) {
   impl_->TruncatePrefix(end_index);
+
+  // Compacted entries are never read again
+  cache_.erase(cache_.begin(), cache_.lower_bound(end_index));
+
+  while (terms_begin_ < end_index && !terms_.empty()) {
+    terms_.pop_front();
+    ++terms_begin_;
+  }
 }
 
 std::shared_ptr<Log::ILogImpl> Log::MakeLogImpl(
@@ -57,4 +132,26 @@ std::shared_ptr<Log::ILogImpl> Log::MakeLogImpl(
   return std::make_shared<persist::rsm::raft::FileLog>(fs, log_path);
 }
 
+Log::CachedEntry* Log::FindCached(size_t index) const {
+  auto it = cache_.find(index);
+  return it != cache_.end() ? &it->second : nullptr;
+}
+
+void Log::Cache(size_t index, CachedEntry entry) const {
+  cache_.insert_or_assign(index, std::move(entry));
+
+  // Evict entries left behind by the tail
+  while (!cache_.empty() && !InTail(cache_.begin()->first)) {
+    cache_.erase(cache_.begin());
+  }
+}
+
+void Log::IndexTerms(size_t index) const {
+  while (terms_begin_ > index) {
+    auto prev = terms_begin_ - 1;
+    terms_.push_front(Read(prev).term);
+    terms_begin_ = prev;
+  }
+}
+
 }  // namespace rsm
@@ -5,11 +5,23 @@
 #include <persist/fs/path.hpp>
 #include <persist/rsm/raft/log/log.hpp>
 
+#include <deque>
+#include <map>
+#include <optional>
+
 namespace rsm {
 
 // Persistent log
 // Indexed from 1
 // NOT thread safe, external synchronization required
+//
+// Replication and apply re-read the tail of the log, so the last
+// kCacheCapacity entries are kept in memory, serialized and (once read)
+// deserialized, and terms of entries seen since Open in a dense term
+// index: Read of the tail and Term do not touch the disk on the hot path
+//
+// Each entry is serialized once: by Append on the leader, encoded entries
+// are shipped to followers and appended there as is
 
 class Log {
  public:
@@ -20,13 +32,19 @@ class Log {
 
   LogEntry Read(size_t index) const;
 
+  // Serialized entry for AppendEntries
+  EncodedLogEntry ReadEncoded(size_t index) const;
+
   size_t Length() const;
 
   // Append entries[start_offset:]
   void Append(const LogEntries& entries, size_t start_offset = 0);
+  // Without decode / encode
+  void Append(const EncodedLogEntries& entries, size_t start_offset = 0);
 
   void TruncateSuffix(size_t from_index);
 
+  // 0 for index 0
   uint64_t Term(size_t index) const;
 
   // For leader election
@@ -38,11 +56,40 @@ class Log {
  private:
   using ILogImpl = persist::rsm::raft::IContinuousLog;
 
+  struct CachedEntry {
+    muesli::Bytes data;
+    // Decoded on first Read
+    std::optional<LogEntry> entry;
+  };
+
   std::shared_ptr<ILogImpl> MakeLogImpl(persist::fs::IFileSystem* fs,
                                         const persist::fs::Path& store_dir);
 
+  // nullptr if not cached
+  CachedEntry* FindCached(size_t index) const;
+
+  bool InTail(size_t index) const {
+    return index + kCacheCapacity > length_;
+  }
+
+  void Cache(size_t index, CachedEntry entry) const;
+
+  // Extend term index down to `index`
+  void IndexTerms(size_t index) const;
+
  private:
+  static const size_t kCacheCapacity = 1024;
+
   std::shared_ptr<ILogImpl> impl_;
+
+  size_t length_ = 0;
+
+  // Entries in the tail of the log, filled by Append and on demand
+  mutable std::map<size_t, CachedEntry> cache_;
+
+  // Terms of entries [terms_begin_, length_]
+  mutable std::deque<uint64_t> terms_;
+  mutable size_t terms_begin_ = 1;
 };
 
 }  // namespace rsm
@@ -2,6 +2,7 @@
 
 #include <rsm/client/command.hpp>
 
+#include <muesli/bytes.hpp>
 #include <muesli/serializable.hpp>
 #include <cereal/types/vector.hpp>
 
@@ -18,4 +19,17 @@ struct LogEntry {
 
 using LogEntries = std::vector<LogEntry>;
 
+// Serialized LogEntry + its term
+// Encoded once by the leader, then shipped in AppendEntries and
+// persisted by followers as is
+
+struct EncodedLogEntry {
+  uint64_t term;
+  muesli::Bytes data;
+
+  MUESLI_SERIALIZABLE(term, data)
+};
+
+using EncodedLogEntries = std::vector<EncodedLogEntry>;
+
 }  // namespace rsm
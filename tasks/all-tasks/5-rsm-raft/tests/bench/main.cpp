@@ -0,0 +1,176 @@
+#include <kv/client.hpp>
+#include <kv/main.hpp>
+#include <rsm/proxy/main.hpp>
+
+// Node
+#include <whirl/node/runtime/shortcuts.hpp>
+
+// Logging
+#include <timber/log.hpp>
+
+// Concurrency
+#include <await/fibers/core/api.hpp>
+#include <await/fibers/sync/future.hpp>
+
+// Simulation
+#include <matrix/facade/world.hpp>
+#include <matrix/world/global/vars.hpp>
+#include <matrix/world/global/time.hpp>
+#include <matrix/client/rpc.hpp>
+#include <matrix/test/main.hpp>
+#include <matrix/test/runner.hpp>
+
+#include <commute/rpc/id.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <tests/time_models/async_1.hpp>
+
+using namespace whirl;
+
+//////////////////////////////////////////////////////////////////////
+
+// Write throughput of the leader vs number of closed-loop clients:
+// with more clients in flight the leader appends larger batches,
+// fault-free runs
+//
+// Simulation parameters are derived from the seed, so any --sims
+// covers all configs evenly
+
+struct BenchConfig {
+  size_t replicas;
+  size_t clients;
+};
+
+static const std::vector<BenchConfig> kBenchConfigs{
+    {3, 1},
+    {3, 4},
+    {3, 16},
+};
+
+// Leader election is done by then
+static const matrix::TimePoint kWarmUp = 20000;
+static const Jiffies kTimeLimit = 60000_jfs;
+
+//////////////////////////////////////////////////////////////////////
+
+struct ThroughputStats {
+  size_t commands = 0;
+  uint64_t time = 0;
+
+  // Commands per 1000 jiffies
+  double Throughput() const {
+    return time > 0 ? 1000.0 * commands / time : 0;
+  }
+};
+
+static std::vector<ThroughputStats> throughput_stats(kBenchConfigs.size());
+
+// Current simulation
+static size_t bench_config = 0;
+
+//////////////////////////////////////////////////////////////////////
+
+void Client() {
+  await::fibers::self::SetName("main");
+
+  node::rt::SleepFor(123_jfs);
+
+  timber::Logger logger_{"Client", node::rt::LoggerBackend()};
+
+  auto channel = matrix::client::MakeRpcChannel("proxy", 42);
+
+  kv::Client kv_client{channel};
+
+  // Disjoint keys, contention is irrelevant for the log
+  const auto key = node::rt::GenerateGuid();
+
+  for (size_t i = 0;; ++i) {
+    kv_client.Set(key, std::to_string(i));
+
+    if (matrix::GlobalNow() >= kWarmUp) {
+      ++throughput_stats[bench_config].commands;
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+
+// Seed -> simulation digest
+// Deterministic
+size_t RunSimulation(size_t seed) {
+  auto& runner = matrix::TestRunner::Access();
+
+  bench_config = seed % kBenchConfigs.size();
+  const auto& config = kBenchConfigs[bench_config];
+
+  runner.Verbose() << "Simulation seed: " << seed
+                   << ", replicas: " << config.replicas
+                   << ", clients: " << config.clients << std::endl;
+
+  // Reset RPC ids
+  commute::rpc::ResetIds();
+
+  matrix::facade::World world{seed};
+
+  runner.Configure(world);
+
+  world.SetTimeModel(tests::MakeAsyncTimeModel());
+
+  // Cluster
+  world.MakePool("rsm", kv::ReplicaMain).Size(config.replicas);
+  world.MakePool("proxy", rsm::ProxyMain).Size(2);
+
+  // Clients
+  world.AddClients(Client, /*count=*/config.clients);
+
+  // For proxies
+  world.SetGlobal<std::string>("config.rsm.pool.name", "rsm");
+
+  // For rsm
+  world.SetGlobal<std::string>("config.rsm.store.dir", "/rsm/store");
+  world.SetGlobal<int64_t>("config.rsm.apply.parallelism", 1);
+  world.SetGlobal<int64_t>("config.rsm.sessions.max", 1024);
+
+  // Run simulation
+
+  world.Start();
+  while (world.TimeElapsed() < kTimeLimit) {
+    if (!world.Step()) {
+      break;  // Deadlock
+    }
+  }
+
+  auto& stats = throughput_stats[bench_config];
+  stats.time += world.TimeElapsed().Count() - kWarmUp;
+
+  size_t digest = world.Stop();
+
+  if (world.TimeElapsed() < kTimeLimit) {
+    runner.Report() << "Simulation for seed = " << seed
+                    << " deadlocked" << std::endl;
+    runner.Fail();
+  }
+
+  return digest;
+}
+
+void PrintThroughputReport(std::ostream& out) {
+  out << "Write throughput:" << std::endl;
+  for (size_t i = 0; i < kBenchConfigs.size(); ++i) {
+    const auto& config = kBenchConfigs[i];
+    const auto& stats = throughput_stats[i];
+    out << "  replicas = " << config.replicas
+        << ", clients = " << config.clients << ": " << stats.Throughput()
+        << " commands / 1000 jiffies (" << stats.commands << " commands)"
+        << std::endl;
+  }
+}
+
+int main(int argc, const char** argv) {
+  int exit_code = matrix::Main(argc, argv, RunSimulation);
+  PrintThroughputReport(std::cout);
+  return exit_code;
+}
@@ -163,6 +163,8 @@ size_t RunSimulation(size_t seed) {
 
   // For rsm
   world.SetGlobal<std::string>("config.rsm.store.dir", "/rsm/store");
+  world.SetGlobal<int64_t>("config.rsm.apply.parallelism", 4);
+  world.SetGlobal<int64_t>("config.rsm.sessions.max", 1024);
 
   // Run simulation
 